@@ -0,0 +1,31 @@
+#include <stdbool.h>
+#include "calendar_backup.h"
+#include "checkpoint.h"
+#include "nrf_calendar.h"
+
+static nrf_cal_state_t m_saved;             /**< Newest checkpoint. */
+static bool            m_saved_valid = false;
+
+void calendar_backup_restore(uint32_t min_epoch)
+{
+    m_saved_valid = checkpoint_load(CHECKPOINT_KEY_CALENDAR, &m_saved, sizeof(m_saved));
+    nrf_cal_restore(m_saved_valid ? &m_saved : NULL, min_epoch);
+}
+
+void calendar_backup_update(void)
+{
+    nrf_cal_state_t state;
+
+    nrf_cal_state_get(&state);
+    if (m_saved_valid &&
+        (state.drift_q32 == m_saved.drift_q32) &&
+        (state.uncertain == m_saved.uncertain) &&
+        (state.epoch - m_saved.epoch < CALENDAR_BACKUP_INTERVAL))
+    {
+        return;
+    }
+
+    checkpoint_save(CHECKPOINT_KEY_CALENDAR, &state, sizeof(state));
+    m_saved       = state;
+    m_saved_valid = true;
+}
@@ -0,0 +1,26 @@
+#ifndef CALENDAR_BACKUP_H__
+#define CALENDAR_BACKUP_H__
+
+#include <stdint.h>
+
+/**
+ * @brief Keeps the calendar going over resets that lose RAM.
+ *
+ * Resets that keep RAM powered are covered by the calendar itself. For the others, the
+ * calendar state is checkpointed to flash whenever the calibration or the trust in the
+ * time changes, and otherwise at most once every CALENDAR_BACKUP_INTERVAL seconds, so the
+ * flash wear stays negligible next to the log. On boot the calendar continues from the
+ * checkpoint or the newest logged timestamp, whichever is later, and the time is marked
+ * uncertain until it is set again.
+ */
+
+#define CALENDAR_BACKUP_INTERVAL    (6 * 3600)  /**< Longest time between two checkpoints, in seconds. */
+
+// Restores the calendar. Call once after nrf_cal_init() and checkpoint_init(), passing the
+// newest logged timestamp.
+void calendar_backup_restore(uint32_t min_epoch);
+
+// Saves the calendar state if it changed or the last checkpoint is old.
+void calendar_backup_update(void);
+
+#endif // CALENDAR_BACKUP_H__
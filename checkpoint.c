@@ -0,0 +1,230 @@
+#include <string.h>
+#include "checkpoint.h"
+
+#define CHECKPOINT_PAGE_WORDS       (FLASH_LOG_PAGE_SIZE / sizeof(uint32_t))
+#define CHECKPOINT_HEADER_WORDS     (sizeof(checkpoint_page_header_t) / sizeof(uint32_t))
+#define CHECKPOINT_RECORD_WORDS     (sizeof(checkpoint_record_t) / sizeof(uint32_t))
+#define CHECKPOINT_DATA_MAX_WORDS   ((CHECKPOINT_DATA_MAX_SIZE + 3) / 4)
+
+#define CHECKPOINT_PAGE_MAGIC       (0x43484B50) // "CHKP"
+#define CHECKPOINT_RECORD_VALID     (0xC5A3)
+#define CHECKPOINT_ERASED_WORD      (0xFFFFFFFF)
+
+typedef struct
+{
+    uint32_t sequence;          /**< Incremented on every page swap. */
+    uint32_t magic;             /**< CHECKPOINT_PAGE_MAGIC. */
+} checkpoint_page_header_t;
+
+typedef struct
+{
+    uint32_t value;             /**< CHECKPOINT_RECORD_VALID << 16 | key, programmed last. */
+    uint32_t size;              /**< Payload length in bytes. */
+} checkpoint_record_t;
+
+typedef struct
+{
+    uint32_t * p_region;
+    uint32_t   page;            /**< Active page. */
+    uint32_t   sequence;        /**< Sequence number of the active page. */
+    uint32_t   offset;          /**< Offset in words of the first free word in the active page. */
+    bool       valid;           /**< The active page has been formatted. */
+} checkpoint_store_t;
+
+static checkpoint_store_t m_store;
+static uint32_t           m_record_buf[CHECKPOINT_RECORD_WORDS + CHECKPOINT_DATA_MAX_WORDS];
+
+static uint32_t * page_get(uint32_t page)
+{
+    return m_store.p_region + page * CHECKPOINT_PAGE_WORDS;
+}
+
+static bool page_is_valid(uint32_t page)
+{
+    checkpoint_page_header_t const * p_header = (checkpoint_page_header_t const *)page_get(page);
+
+    return (p_header->magic == CHECKPOINT_PAGE_MAGIC) && (p_header->sequence != CHECKPOINT_ERASED_WORD);
+}
+
+// Returns the record at the given offset of the active page, or NULL where the records end.
+static checkpoint_record_t const * record_get(uint32_t offset, uint32_t * p_words)
+{
+    checkpoint_record_t const * p_record = (checkpoint_record_t const *)(page_get(m_store.page) + offset);
+
+    if ((offset + CHECKPOINT_RECORD_WORDS > CHECKPOINT_PAGE_WORDS) ||
+        (p_record->size > CHECKPOINT_DATA_MAX_SIZE))
+    {
+        return NULL;
+    }
+
+    *p_words = CHECKPOINT_RECORD_WORDS + (p_record->size + 3) / 4;
+    if (*p_words > CHECKPOINT_PAGE_WORDS - offset)
+    {
+        return NULL;
+    }
+    return p_record;
+}
+
+// Returns the newest valid record of a key in the active page.
+static checkpoint_record_t const * record_find(uint8_t key)
+{
+    checkpoint_record_t const * p_found = NULL;
+    checkpoint_record_t const * p_record;
+    uint32_t offset;
+    uint32_t words;
+
+    if (!m_store.valid)
+    {
+        return NULL;
+    }
+
+    for (offset = CHECKPOINT_HEADER_WORDS; offset < m_store.offset; offset += words)
+    {
+        p_record = record_get(offset, &words);
+        if (p_record == NULL)
+        {
+            break;
+        }
+        if (p_record->value == (((uint32_t)CHECKPOINT_RECORD_VALID << 16) | key))
+        {
+            p_found = p_record;
+        }
+    }
+
+    return p_found;
+}
+
+static void record_write(uint32_t * p_dst, uint32_t const * p_src, uint32_t words)
+{
+    // The value word goes last, so a record only becomes valid once it is complete.
+    flash_log_nvmc_write_words(p_dst + 1, p_src + 1, words - 1);
+    flash_log_nvmc_write_words(p_dst, p_src, 1);
+}
+
+// Moves the newest record of every key to the other page and makes it the active page.
+static void page_swap(void)
+{
+    uint32_t                 page    = (m_store.page + 1) % CHECKPOINT_PAGE_COUNT;
+    uint32_t               * p_page  = page_get(page);
+    uint32_t                 offset  = CHECKPOINT_HEADER_WORDS;
+    checkpoint_page_header_t header;
+    uint8_t                  key;
+
+    flash_log_nvmc_page_erase(p_page);
+
+    for (key = 0; key < CHECKPOINT_KEY_COUNT; key++)
+    {
+        checkpoint_record_t const * p_record = record_find(key);
+        uint32_t words;
+
+        if ((p_record == NULL) || (p_record->size == 0))
+        {
+            continue;
+        }
+        words = CHECKPOINT_RECORD_WORDS + (p_record->size + 3) / 4;
+        record_write(p_page + offset, (uint32_t const *)p_record, words);
+        offset += words;
+    }
+
+    header.sequence = m_store.valid ? m_store.sequence + 1 : 0;
+    header.magic    = CHECKPOINT_PAGE_MAGIC;
+    flash_log_nvmc_write_words(p_page, (uint32_t const *)&header, CHECKPOINT_HEADER_WORDS);
+
+    m_store.page     = page;
+    m_store.sequence = header.sequence;
+    m_store.offset   = offset;
+    m_store.valid    = true;
+}
+
+void checkpoint_init(uint32_t * p_region)
+{
+    bool     valid0;
+    bool     valid1;
+    uint32_t offset;
+    uint32_t words;
+
+    m_store.p_region = p_region;
+    m_store.page     = 0;
+    m_store.valid    = false;
+    m_store.offset   = CHECKPOINT_PAGE_WORDS;
+
+    valid0 = page_is_valid(0);
+    valid1 = page_is_valid(1);
+    if (!valid0 && !valid1)
+    {
+        // Formatted by the first save.
+        return;
+    }
+
+    if (valid1 && (!valid0 ||
+                   ((int32_t)(((checkpoint_page_header_t const *)page_get(1))->sequence -
+                              ((checkpoint_page_header_t const *)page_get(0))->sequence) > 0)))
+    {
+        m_store.page = 1;
+    }
+    m_store.sequence = ((checkpoint_page_header_t const *)page_get(m_store.page))->sequence;
+    m_store.valid    = true;
+
+    // Find the first free word. Anything unreadable makes the page count as full.
+    for (offset = CHECKPOINT_HEADER_WORDS; offset < CHECKPOINT_PAGE_WORDS; offset += words)
+    {
+        checkpoint_record_t const * p_record = (checkpoint_record_t const *)(page_get(m_store.page) + offset);
+
+        if ((p_record->value == CHECKPOINT_ERASED_WORD) && (p_record->size == CHECKPOINT_ERASED_WORD))
+        {
+            break;
+        }
+        if (record_get(offset, &words) == NULL)
+        {
+            offset = CHECKPOINT_PAGE_WORDS;
+            break;
+        }
+    }
+    m_store.offset = offset;
+}
+
+bool checkpoint_load(uint8_t key, void * p_data, uint32_t size)
+{
+    checkpoint_record_t const * p_record = record_find(key);
+
+    if ((p_record == NULL) || (p_record->size != size))
+    {
+        return false;
+    }
+
+    memcpy(p_data, p_record + 1, size);
+    return true;
+}
+
+void checkpoint_save(uint8_t key, void const * p_data, uint32_t size)
+{
+    checkpoint_record_t * p_record = (checkpoint_record_t *)m_record_buf;
+    uint32_t              words    = CHECKPOINT_RECORD_WORDS + (size + 3) / 4;
+
+    if ((key >= CHECKPOINT_KEY_COUNT) || (size > CHECKPOINT_DATA_MAX_SIZE))
+    {
+        return;
+    }
+
+    p_record->value = ((uint32_t)CHECKPOINT_RECORD_VALID << 16) | key;
+    p_record->size  = size;
+    memset(p_record + 1, 0xFF, CHECKPOINT_DATA_MAX_WORDS * sizeof(uint32_t));
+    if (size > 0)
+    {
+        memcpy(p_record + 1, p_data, size);
+    }
+
+    if (m_store.offset + words > CHECKPOINT_PAGE_WORDS)
+    {
+        page_swap();
+    }
+
+    record_write(page_get(m_store.page) + m_store.offset, m_record_buf, words);
+    m_store.offset += words;
+}
+
+void checkpoint_clear(uint8_t key)
+{
+    // An empty record hides older ones and is dropped by the next page swap.
+    checkpoint_save(key, NULL, 0);
+}
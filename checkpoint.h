@@ -0,0 +1,41 @@
+#ifndef CHECKPOINT_H__
+#define CHECKPOINT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_log.h"
+
+/**
+ * @brief Small store for state that must survive a reset, e.g. the trip summary.
+ *
+ * Every save appends a record to the active page; the newest record of a key wins. When the
+ * active page is full, the newest record of every key is copied to the other page, whose
+ * header is written last, so a reset during the swap leaves the old page in charge.
+ * Like the log, a record only becomes valid once its first word is programmed.
+ */
+
+#define CHECKPOINT_PAGE_COUNT       (2u)
+#define CHECKPOINT_START_ADDR       (FLASH_LOG_START_ADDR + FLASH_LOG_PAGE_COUNT * FLASH_LOG_PAGE_SIZE)
+
+#define CHECKPOINT_KEY_COUNT        (8u)        /**< Keys are 0 to CHECKPOINT_KEY_COUNT - 1. */
+#define CHECKPOINT_DATA_MAX_SIZE    (128u)      /**< Largest record payload in bytes. */
+
+// Checkpoint keys. Each owner keeps one record per key.
+#define CHECKPOINT_KEY_TRIP         (0u)
+#define CHECKPOINT_KEY_CALENDAR     (1u)
+#define CHECKPOINT_KEY_RADIO        (2u)
+
+// Locates the active page of the store over CHECKPOINT_PAGE_COUNT pages at p_region.
+void checkpoint_init(uint32_t * p_region);
+
+// Copies the newest record of a key to p_data. Returns false if there is no record of
+// exactly size bytes.
+bool checkpoint_load(uint8_t key, void * p_data, uint32_t size);
+
+// Appends a record of at most CHECKPOINT_DATA_MAX_SIZE bytes.
+void checkpoint_save(uint8_t key, void const * p_data, uint32_t size);
+
+// Invalidates every record of a key.
+void checkpoint_clear(uint8_t key);
+
+#endif // CHECKPOINT_H__
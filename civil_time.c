@@ -0,0 +1,98 @@
+#include "civil_time.h"
+
+#define CIVIL_TIME_SECONDS_PER_DAY  (86400u)
+#define CIVIL_TIME_DAYS_PER_ERA     (146097u)   /**< Days in 400 years. */
+#define CIVIL_TIME_EPOCH_DAYS       (719468u)   /**< Days from 0000-03-01 to 1970-01-01. */
+#define CIVIL_TIME_YEAR_MIN         (1970u)
+#define CIVIL_TIME_YEAR_MAX         (2105u)
+
+// The conversions count years from March, so the leap day is the last day of the year and
+// month lengths follow a fixed pattern: day of year = (153 * month + 2) / 5, months from 0.
+
+void civil_time_from_epoch(uint32_t epoch, civil_time_t * p_time)
+{
+    uint32_t days   = epoch / CIVIL_TIME_SECONDS_PER_DAY + CIVIL_TIME_EPOCH_DAYS;
+    uint32_t second = epoch % CIVIL_TIME_SECONDS_PER_DAY;
+    uint32_t era    = days / CIVIL_TIME_DAYS_PER_ERA;
+    uint32_t doe    = days - era * CIVIL_TIME_DAYS_PER_ERA;
+    uint32_t yoe    = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy    = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp     = (5 * doy + 2) / 153;
+    uint32_t month  = (mp < 10) ? mp + 3 : mp - 9;
+
+    p_time->year   = (uint16_t)(era * 400 + yoe + (month <= 2));
+    p_time->month  = (uint8_t)month;
+    p_time->day    = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+    p_time->hour   = (uint8_t)(second / 3600);
+    p_time->minute = (uint8_t)(second / 60 % 60);
+    p_time->second = (uint8_t)(second % 60);
+}
+
+uint32_t civil_time_to_epoch(civil_time_t const * p_time)
+{
+    uint32_t year = p_time->year - (p_time->month <= 2);
+    uint32_t era  = year / 400;
+    uint32_t yoe  = year - era * 400;
+    uint32_t mp   = (p_time->month > 2) ? p_time->month - 3u : p_time->month + 9u;
+    uint32_t doy  = (153 * mp + 2) / 5 + p_time->day - 1;
+    uint32_t doe  = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    uint32_t days = era * CIVIL_TIME_DAYS_PER_ERA + doe - CIVIL_TIME_EPOCH_DAYS;
+
+    return days * CIVIL_TIME_SECONDS_PER_DAY +
+           p_time->hour * 3600u + p_time->minute * 60u + p_time->second;
+}
+
+bool civil_time_valid(civil_time_t const * p_time)
+{
+    static uint8_t const month_days[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    uint32_t year = p_time->year;
+
+    if ((year < CIVIL_TIME_YEAR_MIN) || (year > CIVIL_TIME_YEAR_MAX) ||
+        (p_time->month < 1) || (p_time->month > 12) ||
+        (p_time->day < 1) || (p_time->day > month_days[p_time->month - 1]) ||
+        (p_time->hour > 23) || (p_time->minute > 59) || (p_time->second > 59))
+    {
+        return false;
+    }
+
+    // 29 February only exists in leap years.
+    if ((p_time->month == 2) && (p_time->day == 29))
+    {
+        return ((year % 4 == 0) && (year % 100 != 0)) || (year % 400 == 0);
+    }
+    return true;
+}
+
+static char * digits_put(char * p_buf, uint32_t value, uint32_t count)
+{
+    char * p_end = p_buf + count;
+
+    while (count-- > 0)
+    {
+        p_buf[count] = (char)('0' + value % 10);
+        value /= 10;
+    }
+    return p_end;
+}
+
+void civil_time_format(uint32_t epoch, char * p_buf)
+{
+    civil_time_t time;
+
+    civil_time_from_epoch(epoch, &time);
+
+    p_buf    = digits_put(p_buf, time.day, 2);
+    *p_buf++ = '/';
+    p_buf    = digits_put(p_buf, time.month, 2);
+    *p_buf++ = '/';
+    p_buf    = digits_put(p_buf, time.year, 4);
+    *p_buf++ = ' ';
+    *p_buf++ = '-';
+    *p_buf++ = ' ';
+    p_buf    = digits_put(p_buf, time.hour, 2);
+    *p_buf++ = ':';
+    p_buf    = digits_put(p_buf, time.minute, 2);
+    *p_buf++ = ':';
+    p_buf    = digits_put(p_buf, time.second, 2);
+    *p_buf   = '\0';
+}
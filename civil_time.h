@@ -0,0 +1,43 @@
+#ifndef CIVIL_TIME_H__
+#define CIVIL_TIME_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Conversion between epoch seconds and calendar dates.
+ *
+ * Samples and the calendar carry plain 32-bit seconds since 1970-01-01 00:00:00; dates are
+ * only worked out when something is shown to a person. Unlike mktime(), localtime() and
+ * strftime(), these functions keep no state, allocate nothing and are safe to call from any
+ * context. The clock has no time zone, so all times are UTC. Valid from 1970 to 2105.
+ *
+ * Plain C without hardware dependencies.
+ */
+
+typedef struct
+{
+    uint16_t year;                  /**< e.g. 2021. */
+    uint8_t  month;                 /**< 1 to 12. */
+    uint8_t  day;                   /**< 1 to 31. */
+    uint8_t  hour;                  /**< 0 to 23. */
+    uint8_t  minute;                /**< 0 to 59. */
+    uint8_t  second;                /**< 0 to 59. */
+} civil_time_t;
+
+// Size of the buffer civil_time_format() writes, "dd/mm/yyyy - HH:MM:SS" and a terminator.
+#define CIVIL_TIME_STRING_SIZE      (22u)
+
+// Splits epoch seconds into a calendar date and time.
+void civil_time_from_epoch(uint32_t epoch, civil_time_t * p_time);
+
+// Returns the epoch seconds of a calendar date and time. The fields must be valid.
+uint32_t civil_time_to_epoch(civil_time_t const * p_time);
+
+// Returns true if the fields form an existing date and time within the valid range.
+bool civil_time_valid(civil_time_t const * p_time);
+
+// Writes epoch seconds as "dd/mm/yyyy - HH:MM:SS" to a buffer of CIVIL_TIME_STRING_SIZE bytes.
+void civil_time_format(uint32_t epoch, char * p_buf);
+
+#endif // CIVIL_TIME_H__
@@ -0,0 +1,78 @@
+#include <string.h>
+#include "excursion.h"
+
+excursion_profile_t const g_excursion_profiles[] =
+{
+    { "frozen",  -25 * 4, -18 * 4 },
+    { "chilled",   2 * 4,   8 * 4 },
+    { "ambient",  15 * 4,  25 * 4 },
+    { NULL,            0,       0 },
+};
+
+void excursion_reset(excursion_summary_t * p_summary, int16_t lower, int16_t upper)
+{
+    memset(p_summary, 0, sizeof(*p_summary));
+    p_summary->lower = lower;
+    p_summary->upper = upper;
+}
+
+void excursion_update(excursion_summary_t * p_summary, uint32_t timestamp, int32_t temperature)
+{
+    int8_t state = 0;
+
+    if (temperature > p_summary->upper)
+    {
+        state = 1;
+        if (temperature - p_summary->upper > p_summary->max_above)
+        {
+            p_summary->max_above = temperature - p_summary->upper;
+        }
+    }
+    else if (temperature < p_summary->lower)
+    {
+        state = -1;
+        if (p_summary->lower - temperature > p_summary->max_below)
+        {
+            p_summary->max_below = p_summary->lower - temperature;
+        }
+    }
+
+    // An interval running backwards means the clock was set back; it is not charged.
+    if ((p_summary->samples > 0) && ((int32_t)(timestamp - p_summary->last_timestamp) > 0))
+    {
+        uint32_t interval = timestamp - p_summary->last_timestamp;
+
+        if (p_summary->state > 0)
+        {
+            p_summary->time_above += interval;
+        }
+        else if (p_summary->state < 0)
+        {
+            p_summary->time_below += interval;
+        }
+    }
+
+    if ((state != 0) && ((p_summary->samples == 0) || (p_summary->state == 0)))
+    {
+        if (p_summary->count == 0)
+        {
+            p_summary->first_start = timestamp;
+        }
+        p_summary->count++;
+        p_summary->last_start = timestamp;
+        p_summary->last_end   = 0;
+    }
+    else if ((state == 0) && (p_summary->state != 0))
+    {
+        p_summary->last_end = timestamp;
+    }
+
+    p_summary->state          = state;
+    p_summary->last_timestamp = timestamp;
+    p_summary->samples++;
+}
+
+bool excursion_passed(excursion_summary_t const * p_summary)
+{
+    return p_summary->count == 0;
+}
@@ -0,0 +1,58 @@
+#ifndef EXCURSION_H__
+#define EXCURSION_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Incremental detection of temperature excursions.
+ *
+ * Fed one sample at a time, the detector keeps a compact summary of how long and how far
+ * the temperature left the limits of the active profile, so the verdict is known at any
+ * time without reading the log back. The interval between two samples is charged to the
+ * state of the earlier sample. An excursion starts with the first sample outside the
+ * limits and ends with the next sample inside them.
+ *
+ * Plain C without hardware dependencies; temperatures are in 0.25 °C units.
+ */
+
+typedef struct
+{
+    char const * p_name;
+    int16_t      lower;             /**< Lowest acceptable temperature. */
+    int16_t      upper;             /**< Highest acceptable temperature. */
+} excursion_profile_t;
+
+// Built-in limit profiles, terminated by an entry with a NULL name.
+extern excursion_profile_t const g_excursion_profiles[];
+
+#define EXCURSION_DEFAULT_PROFILE   (1u)    /**< Index of "chilled" in g_excursion_profiles. */
+
+typedef struct
+{
+    int16_t  lower;                 /**< Limits in force. */
+    int16_t  upper;
+    int8_t   state;                 /**< -1 below, 0 within, 1 above the limits, at the last sample. */
+    uint8_t  reserved[3];
+    uint32_t samples;               /**< Number of samples seen. */
+    uint32_t last_timestamp;        /**< Timestamp of the last sample. */
+    uint32_t time_above;            /**< Seconds spent above the upper limit. */
+    uint32_t time_below;            /**< Seconds spent below the lower limit. */
+    int32_t  max_above;             /**< Largest rise above the upper limit. */
+    int32_t  max_below;             /**< Largest drop below the lower limit. */
+    uint32_t count;                 /**< Number of excursions. */
+    uint32_t first_start;           /**< Start of the first excursion. */
+    uint32_t last_start;            /**< Start of the latest excursion. */
+    uint32_t last_end;              /**< End of the latest excursion, 0 while it is ongoing. */
+} excursion_summary_t;
+
+// Resets the summary and sets the limits for a new trip.
+void excursion_reset(excursion_summary_t * p_summary, int16_t lower, int16_t upper);
+
+// Accounts for a new sample.
+void excursion_update(excursion_summary_t * p_summary, uint32_t timestamp, int32_t temperature);
+
+// Returns true if the temperature never left the limits.
+bool excursion_passed(excursion_summary_t const * p_summary);
+
+#endif // EXCURSION_H__
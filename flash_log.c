@@ -0,0 +1,830 @@
+#include <string.h>
+#include "flash_log.h"
+
+#define FLASH_LOG_HEADER_WORDS      (sizeof(flash_log_page_header_t) / sizeof(uint32_t))
+#define FLASH_LOG_BLOCK_WORDS       (sizeof(flash_log_block_t) / sizeof(uint32_t))
+#define FLASH_LOG_PAGE_WORDS        (FLASH_LOG_PAGE_SIZE / sizeof(uint32_t))
+
+// Longest encoding of one delta: escape byte, 5-byte interval change, 3-byte temperature change.
+#define FLASH_LOG_DELTA_MAX_BYTES   (9u)
+#define FLASH_LOG_BLOCK_MAX_WORDS   (FLASH_LOG_BLOCK_WORDS + \
+                                     ((FLASH_LOG_BLOCK_MAX_SAMPLES - 1) * FLASH_LOG_DELTA_MAX_BYTES + 3) / 4)
+
+#define FLASH_LOG_DELTA_ESCAPE      (0x80)
+#define FLASH_LOG_ERASED_WORD       (0xFFFFFFFF)
+#define FLASH_LOG_ERASED_BYTE       (0xFF)
+#define FLASH_LOG_NO_PAGE           (UINT32_MAX)
+
+typedef enum
+{
+    PAGE_STATE_BLANK,           /**< Page fully erased, erase counter unknown. */
+    PAGE_STATE_FREE,            /**< Page erased, header carries the erase counter. */
+    PAGE_STATE_STARTED,         /**< Page is part of the log. */
+    PAGE_STATE_DIRTY,           /**< Anything else, e.g. a header torn by a reset. */
+} page_state_t;
+
+typedef struct
+{
+    uint32_t * p_region;        /**< First word of the log region. */
+    uint32_t   page_count;      /**< Number of pages in the log region. */
+    uint32_t   oldest_page;     /**< Page holding the oldest samples. */
+    uint32_t   newest_page;     /**< Page holding the head, FLASH_LOG_NO_PAGE if the log is empty. */
+    uint32_t   newest_sequence; /**< Sequence number of the newest page. */
+    uint32_t   newest_offset;   /**< Offset in words of the first free word in the newest page. */
+    uint32_t   newest_samples;  /**< Number of valid samples in the newest page. */
+    uint32_t   count;           /**< Number of valid samples in the whole log. */
+    bool       time_uncertain;  /**< New blocks get FLASH_LOG_BLOCK_UNCERTAIN. */
+} flash_log_t;
+
+static flash_log_t m_log;
+static uint32_t    m_block_buf[FLASH_LOG_BLOCK_MAX_WORDS];  /**< Block being encoded. */
+
+static uint32_t * page_get(uint32_t page)
+{
+    return m_log.p_region + page * FLASH_LOG_PAGE_WORDS;
+}
+
+static flash_log_page_header_t * page_header_get(uint32_t page)
+{
+    return (flash_log_page_header_t *)page_get(page);
+}
+
+static uint32_t page_next(uint32_t page)
+{
+    return (page + 1 == m_log.page_count) ? 0 : page + 1;
+}
+
+static bool page_body_is_erased(uint32_t page)
+{
+    uint32_t const * p_word = page_get(page);
+    uint32_t i;
+
+    for (i = FLASH_LOG_HEADER_WORDS; i < FLASH_LOG_PAGE_WORDS; i++)
+    {
+        if (p_word[i] != FLASH_LOG_ERASED_WORD)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static page_state_t page_state_get(uint32_t page)
+{
+    flash_log_page_header_t const * p_header = page_header_get(page);
+
+    if (p_header->info == FLASH_LOG_ERASED_WORD)
+    {
+        return (p_header->sequence == FLASH_LOG_ERASED_WORD) ? PAGE_STATE_BLANK : PAGE_STATE_DIRTY;
+    }
+    if ((p_header->info >> 16) != FLASH_LOG_PAGE_MAGIC)
+    {
+        return PAGE_STATE_DIRTY;
+    }
+    return (p_header->sequence == FLASH_LOG_ERASED_WORD) ? PAGE_STATE_FREE : PAGE_STATE_STARTED;
+}
+
+uint32_t flash_log_erase_count_get(uint32_t page)
+{
+    page_state_t state = page_state_get(page);
+
+    if ((state == PAGE_STATE_FREE) || (state == PAGE_STATE_STARTED))
+    {
+        return page_header_get(page)->info & 0x0000FFFF;
+    }
+    return 0;
+}
+
+// Erases a page and records the erase in its header, leaving the page free. A page whose
+// header was lost inherits the counter of its predecessor as the best available estimate.
+static void page_recycle(uint32_t page)
+{
+    page_state_t state = page_state_get(page);
+    uint32_t erase_count;
+    uint32_t info;
+
+    if ((state == PAGE_STATE_FREE) || (state == PAGE_STATE_STARTED))
+    {
+        erase_count = flash_log_erase_count_get(page);
+    }
+    else
+    {
+        erase_count = flash_log_erase_count_get((page == 0) ? m_log.page_count - 1 : page - 1);
+    }
+
+    flash_log_nvmc_page_erase(page_get(page));
+
+    info = FLASH_LOG_PAGE_INFO(erase_count + 1);
+    flash_log_nvmc_write_words(&page_header_get(page)->info, &info, 1);
+}
+
+// Makes a page the newest page of the log.
+static void page_start(uint32_t page, uint32_t sequence)
+{
+    page_state_t state = page_state_get(page);
+
+    if (((state != PAGE_STATE_FREE) && (state != PAGE_STATE_BLANK)) || !page_body_is_erased(page))
+    {
+        page_recycle(page);
+    }
+    else if (state == PAGE_STATE_BLANK)
+    {
+        uint32_t info = FLASH_LOG_PAGE_INFO(0);
+        flash_log_nvmc_write_words(&page_header_get(page)->info, &info, 1);
+    }
+
+    flash_log_nvmc_write_words(&page_header_get(page)->sequence, &sequence, 1);
+
+    m_log.newest_page     = page;
+    m_log.newest_sequence = sequence;
+    m_log.newest_offset   = FLASH_LOG_HEADER_WORDS;
+    m_log.newest_samples  = 0;
+}
+
+// Returns true if the page at the given distance from a started page continues its run
+// of consecutive sequence numbers, walking forward or backward around the ring.
+static bool page_in_run(uint32_t page, uint32_t sequence, uint32_t distance, bool forward)
+{
+    uint32_t other;
+
+    if (forward)
+    {
+        other = (page + distance) % m_log.page_count;
+        sequence += distance;
+    }
+    else
+    {
+        other = (page + m_log.page_count - distance) % m_log.page_count;
+        sequence -= distance;
+    }
+
+    return (page_state_get(other) == PAGE_STATE_STARTED) &&
+           (page_header_get(other)->sequence == sequence);
+}
+
+// Returns the length of the run of started pages beginning at the given page, walking
+// forward or backward. Pages in the log always form one such run, so the run ends can be
+// found by binary search.
+static uint32_t run_length(uint32_t page, bool forward)
+{
+    uint32_t sequence = page_header_get(page)->sequence;
+    uint32_t lo = 1;
+    uint32_t hi = m_log.page_count;
+
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (page_in_run(page, sequence, mid, forward))
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static uint32_t block_words(flash_log_block_t const * p_block)
+{
+    return FLASH_LOG_BLOCK_WORDS + (FLASH_LOG_BLOCK_LENGTH(p_block) + 3) / 4;
+}
+
+// Marks a block torn by a reset, so readers skip it.
+static void block_discard(flash_log_block_t * p_block)
+{
+    uint32_t value = (uint32_t)FLASH_LOG_BLOCK_DISCARDED << 16;
+
+    flash_log_nvmc_write_words(&p_block->value, &value, 1);
+}
+
+static uint32_t zigzag_encode(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t zigzag_decode(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static uint32_t varint_put(uint32_t value, uint8_t * p_out)
+{
+    uint32_t len = 0;
+
+    while (value >= 0x80)
+    {
+        p_out[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    p_out[len++] = (uint8_t)value;
+    return len;
+}
+
+static bool varint_get(flash_log_cursor_t * p_cursor, uint32_t * p_value)
+{
+    uint32_t value = 0;
+    uint32_t shift = 0;
+
+    uint8_t const * p_end = (uint8_t const *)(p_cursor->p_block + 1) +
+                            FLASH_LOG_BLOCK_LENGTH(p_cursor->p_block);
+
+    while ((p_cursor->p_data < p_end) && (shift < 35))
+    {
+        uint8_t byte = *p_cursor->p_data++;
+
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            *p_value = value;
+            return true;
+        }
+        shift += 7;
+    }
+    return false;
+}
+
+// Encodes the change from one sample to the next. Returns the encoding length in bytes.
+static uint32_t delta_encode(flash_log_sample_t const * p_prev,
+                             flash_log_sample_t const * p_sample,
+                             int32_t                    prev_interval,
+                             uint8_t                  * p_out)
+{
+    int32_t interval = (int32_t)(p_sample->timestamp - p_prev->timestamp);
+    int32_t dod      = interval - prev_interval;
+    int32_t dtemp    = (int16_t)p_sample->temperature - (int16_t)p_prev->temperature;
+    uint32_t len;
+
+    if ((dod >= -2) && (dod <= 1) && (dtemp >= -16) && (dtemp <= 15))
+    {
+        p_out[0] = (uint8_t)(((dod & 0x03) << 5) | (dtemp & 0x1F));
+        return 1;
+    }
+
+    p_out[0] = FLASH_LOG_DELTA_ESCAPE;
+    len  = 1;
+    len += varint_put(zigzag_encode(dod), &p_out[len]);
+    len += varint_put(zigzag_encode(dtemp), &p_out[len]);
+    return len;
+}
+
+// Encodes into m_block_buf as many of the given samples as fit in max_words.
+// Returns the number of samples encoded, at least one.
+static uint32_t block_encode(flash_log_sample_t const * p_samples, uint32_t count, uint32_t max_words)
+{
+    flash_log_block_t * p_block   = (flash_log_block_t *)m_block_buf;
+    uint8_t           * p_payload = (uint8_t *)(p_block + 1);
+    uint32_t max_len  = (max_words - FLASH_LOG_BLOCK_WORDS) * sizeof(uint32_t);
+    uint32_t len      = 0;
+    int32_t  interval = 0;
+    int32_t  first_interval;
+    int32_t  interval_seed;
+    uint16_t state;
+    uint32_t n;
+
+    if (count > FLASH_LOG_BLOCK_MAX_SAMPLES)
+    {
+        count = FLASH_LOG_BLOCK_MAX_SAMPLES;
+    }
+
+    // Seed the delta coding with the first interval, so a steady series needs no escape.
+    if (count > 1)
+    {
+        first_interval = (int32_t)(p_samples[1].timestamp - p_samples[0].timestamp);
+        if ((first_interval > 0) && (first_interval <= FLASH_LOG_BLOCK_MAX_INTERVAL))
+        {
+            interval = first_interval;
+        }
+    }
+    interval_seed = interval;
+
+    for (n = 1; n < count; n++)
+    {
+        uint8_t  delta[FLASH_LOG_DELTA_MAX_BYTES];
+        uint32_t delta_len = delta_encode(&p_samples[n - 1], &p_samples[n], interval, delta);
+
+        if (len + delta_len > max_len)
+        {
+            break;
+        }
+        memcpy(&p_payload[len], delta, delta_len);
+        len     += delta_len;
+        interval = (int32_t)(p_samples[n].timestamp - p_samples[n - 1].timestamp);
+    }
+
+    state              = m_log.time_uncertain ? FLASH_LOG_BLOCK_UNCERTAIN : FLASH_LOG_BLOCK_VALID;
+    p_block->value     = ((uint32_t)state << 16) | (uint16_t)(int16_t)p_samples[0].temperature;
+    p_block->timestamp = p_samples[0].timestamp;
+    p_block->size      = FLASH_LOG_BLOCK_SIZE(interval_seed, n, len);
+
+    memset(&p_payload[len], FLASH_LOG_ERASED_BYTE, (4 - (len % 4)) % 4);
+    return n;
+}
+
+// Returns the block at the given offset of a started page, or NULL where the block chain
+// of the page ends.
+static flash_log_block_t const * block_get(uint32_t page, uint32_t offset)
+{
+    flash_log_block_t const * p_block = (flash_log_block_t const *)(page_get(page) + offset);
+
+    if ((page == m_log.newest_page) && (offset >= m_log.newest_offset))
+    {
+        return NULL;
+    }
+    if ((offset + FLASH_LOG_BLOCK_WORDS > FLASH_LOG_PAGE_WORDS) ||
+        (p_block->size == FLASH_LOG_ERASED_WORD) ||
+        (block_words(p_block) > FLASH_LOG_PAGE_WORDS - offset))
+    {
+        return NULL;
+    }
+    return p_block;
+}
+
+// Moves the cursor to the first valid block at or after the given offset, following the
+// ring up to the newest page. Returns false past the end of the log.
+static bool cursor_block_find(flash_log_cursor_t * p_cursor, uint32_t page, uint32_t offset)
+{
+    for (;;)
+    {
+        flash_log_block_t const * p_block = block_get(page, offset);
+
+        if (p_block == NULL)
+        {
+            if (page == m_log.newest_page)
+            {
+                p_cursor->p_block = NULL;
+                return false;
+            }
+            page   = page_next(page);
+            offset = FLASH_LOG_HEADER_WORDS;
+            continue;
+        }
+
+        if (FLASH_LOG_BLOCK_IS_VALID(p_block))
+        {
+            p_cursor->p_block   = p_block;
+            p_cursor->page      = page;
+            p_cursor->offset    = offset;
+            p_cursor->p_data    = (uint8_t const *)(p_block + 1);
+            p_cursor->remaining = FLASH_LOG_BLOCK_SAMPLES(p_block);
+            p_cursor->interval  = (int32_t)FLASH_LOG_BLOCK_INTERVAL(p_block);
+            return true;
+        }
+        offset += block_words(p_block);
+    }
+}
+
+static bool cursor_block_advance(flash_log_cursor_t * p_cursor)
+{
+    return cursor_block_find(p_cursor,
+                             p_cursor->page,
+                             p_cursor->offset + block_words(p_cursor->p_block));
+}
+
+// Decodes the next sample of the current block. The first call returns the anchor sample.
+static flash_log_ret_t block_decode_next(flash_log_cursor_t * p_cursor)
+{
+    flash_log_block_t const * p_block = p_cursor->p_block;
+    int32_t dod;
+    int32_t dtemp;
+    uint8_t byte;
+
+    if (p_cursor->remaining == 0)
+    {
+        return FLASH_LOG_ERROR_NOT_FOUND;
+    }
+
+    if (p_cursor->remaining-- == FLASH_LOG_BLOCK_SAMPLES(p_block))
+    {
+        p_cursor->sample.timestamp   = p_block->timestamp;
+        p_cursor->sample.temperature = (int16_t)(p_block->value & 0x0000FFFF);
+        return FLASH_LOG_SUCCESS;
+    }
+
+    if (p_cursor->p_data >= (uint8_t const *)(p_block + 1) + FLASH_LOG_BLOCK_LENGTH(p_block))
+    {
+        return FLASH_LOG_ERROR_CORRUPTED;
+    }
+
+    byte = *p_cursor->p_data++;
+    if ((byte & FLASH_LOG_DELTA_ESCAPE) == 0)
+    {
+        // Sign-extend the 2-bit interval change and the 5-bit temperature change.
+        dod   = (int32_t)((uint32_t)byte << 25) >> 30;
+        dtemp = (int32_t)((uint32_t)byte << 27) >> 27;
+    }
+    else
+    {
+        uint32_t zz_dod;
+        uint32_t zz_dtemp;
+
+        if (!varint_get(p_cursor, &zz_dod) || !varint_get(p_cursor, &zz_dtemp))
+        {
+            return FLASH_LOG_ERROR_CORRUPTED;
+        }
+        dod   = zigzag_decode(zz_dod);
+        dtemp = zigzag_decode(zz_dtemp);
+    }
+
+    p_cursor->interval           += dod;
+    p_cursor->sample.timestamp   += (uint32_t)p_cursor->interval;
+    p_cursor->sample.temperature  = (int16_t)(p_cursor->sample.temperature + dtemp);
+    return FLASH_LOG_SUCCESS;
+}
+
+// Walks the blocks of a started page. Returns the number of valid samples and stores the
+// offset in words of the first free word. Blocks torn by a reset are discarded if repair
+// is set; a page whose block chain cannot be followed is reported as full.
+static uint32_t page_walk(uint32_t page, uint32_t * p_offset, bool repair)
+{
+    uint32_t * p_page  = page_get(page);
+    uint32_t   offset  = FLASH_LOG_HEADER_WORDS;
+    uint32_t   samples = 0;
+
+    while (offset + FLASH_LOG_BLOCK_WORDS <= FLASH_LOG_PAGE_WORDS)
+    {
+        flash_log_block_t * p_block = (flash_log_block_t *)(p_page + offset);
+        uint32_t words;
+
+        if (p_block->size == FLASH_LOG_ERASED_WORD)
+        {
+            if ((p_block->timestamp != FLASH_LOG_ERASED_WORD) ||
+                (p_block->value != FLASH_LOG_ERASED_WORD))
+            {
+                offset = FLASH_LOG_PAGE_WORDS;
+            }
+            break;
+        }
+
+        words = block_words(p_block);
+        if (words > FLASH_LOG_PAGE_WORDS - offset)
+        {
+            offset = FLASH_LOG_PAGE_WORDS;
+            break;
+        }
+
+        if (FLASH_LOG_BLOCK_IS_VALID(p_block))
+        {
+            samples += FLASH_LOG_BLOCK_SAMPLES(p_block);
+        }
+        else if (repair && (FLASH_LOG_BLOCK_MAGIC(p_block) == FLASH_LOG_BLOCK_NOT_INIT))
+        {
+            // Power was lost before the value word got programmed.
+            block_discard(p_block);
+        }
+        offset += words;
+    }
+
+    *p_offset = offset;
+    return samples;
+}
+
+static uint32_t page_samples_get(uint32_t page)
+{
+    uint32_t offset;
+
+    if (page_header_get(page)->samples != FLASH_LOG_ERASED_WORD)
+    {
+        return page_header_get(page)->samples;
+    }
+    return page_walk(page, &offset, false);
+}
+
+flash_log_ret_t flash_log_init(uint32_t * p_region, uint32_t page_count)
+{
+    uint32_t page;
+    uint32_t forward;
+    uint32_t backward;
+    uint32_t i;
+
+    m_log.p_region    = p_region;
+    m_log.page_count  = page_count;
+    m_log.oldest_page = 0;
+    m_log.newest_page = FLASH_LOG_NO_PAGE;
+    m_log.count       = 0;
+
+    // Pages outside the log may sit anywhere in the ring, so finding a first page of the
+    // log is a linear scan, one header word per page. Once the ring has wrapped, the
+    // first page is almost always part of the log and the scan stops right away.
+    for (page = 0; page < page_count; page++)
+    {
+        if (page_state_get(page) == PAGE_STATE_STARTED)
+        {
+            break;
+        }
+    }
+    if (page == page_count)
+    {
+        return FLASH_LOG_SUCCESS;
+    }
+
+    forward  = run_length(page, true);
+    backward = run_length(page, false);
+    if (forward + backward - 1 > page_count)
+    {
+        return FLASH_LOG_ERROR_CORRUPTED;
+    }
+
+    m_log.newest_page     = (page + forward - 1) % page_count;
+    m_log.oldest_page     = (page + page_count - (backward - 1)) % page_count;
+    m_log.newest_sequence = page_header_get(m_log.newest_page)->sequence;
+    m_log.newest_samples  = page_walk(m_log.newest_page, &m_log.newest_offset, true);
+    m_log.count           = m_log.newest_samples;
+
+    for (i = m_log.oldest_page; i != m_log.newest_page; i = page_next(i))
+    {
+        m_log.count += page_samples_get(i);
+    }
+
+    return FLASH_LOG_SUCCESS;
+}
+
+void flash_log_erase(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < m_log.page_count; i++)
+    {
+        page_state_t state = page_state_get(i);
+
+        if (((state != PAGE_STATE_FREE) && (state != PAGE_STATE_BLANK)) || !page_body_is_erased(i))
+        {
+            page_recycle(i);
+        }
+    }
+
+    m_log.oldest_page = 0;
+    m_log.newest_page = FLASH_LOG_NO_PAGE;
+    m_log.count       = 0;
+}
+
+// Makes sure the newest page has room for at least a block header, starting or
+// reclaiming a page if needed.
+static void head_page_prepare(void)
+{
+    if (m_log.newest_page == FLASH_LOG_NO_PAGE)
+    {
+        // Start an empty log on the least worn page.
+        uint32_t page = 0;
+        uint32_t i;
+
+        for (i = 1; i < m_log.page_count; i++)
+        {
+            if (flash_log_erase_count_get(i) < flash_log_erase_count_get(page))
+            {
+                page = i;
+            }
+        }
+        page_start(page, 0);
+        m_log.oldest_page = page;
+    }
+    else if (m_log.newest_offset + FLASH_LOG_BLOCK_WORDS > FLASH_LOG_PAGE_WORDS)
+    {
+        uint32_t page = page_next(m_log.newest_page);
+
+        // Seal the full page, so mounting does not need to walk its blocks.
+        if (page_header_get(m_log.newest_page)->samples == FLASH_LOG_ERASED_WORD)
+        {
+            flash_log_nvmc_write_words(&page_header_get(m_log.newest_page)->samples,
+                                       &m_log.newest_samples,
+                                       1);
+        }
+
+        if (page == m_log.oldest_page)
+        {
+            // The ring is full: drop the oldest page.
+            m_log.count      -= page_samples_get(page);
+            m_log.oldest_page = page_next(m_log.oldest_page);
+        }
+        page_start(page, m_log.newest_sequence + 1);
+    }
+}
+
+flash_log_ret_t flash_log_append_batch(flash_log_sample_t const * p_samples, uint32_t count)
+{
+    while (count > 0)
+    {
+        uint32_t * p_dst;
+        uint32_t   free_words;
+        uint32_t   words;
+        uint32_t   encoded;
+        uint32_t   i;
+
+        head_page_prepare();
+
+        p_dst      = page_get(m_log.newest_page) + m_log.newest_offset;
+        free_words = FLASH_LOG_PAGE_WORDS - m_log.newest_offset;
+        encoded    = block_encode(p_samples, count, free_words);
+        words      = block_words((flash_log_block_t *)m_block_buf);
+
+        for (i = 0; i < words; i++)
+        {
+            if (p_dst[i] != FLASH_LOG_ERASED_WORD)
+            {
+                return FLASH_LOG_ERROR_CORRUPTED;
+            }
+        }
+
+        // The value word goes last, so a block only becomes valid once it is complete.
+        flash_log_nvmc_write_words(p_dst + 1, m_block_buf + 1, words - 1);
+        flash_log_nvmc_write_words(p_dst, m_block_buf, 1);
+
+        m_log.newest_offset  += words;
+        m_log.newest_samples += encoded;
+        m_log.count          += encoded;
+        p_samples            += encoded;
+        count                -= encoded;
+    }
+
+    return FLASH_LOG_SUCCESS;
+}
+
+void flash_log_time_uncertain_set(bool uncertain)
+{
+    m_log.time_uncertain = uncertain;
+}
+
+flash_log_ret_t flash_log_append(flash_log_sample_t const * p_sample)
+{
+    return flash_log_append_batch(p_sample, 1);
+}
+
+void flash_log_cursor_begin(flash_log_cursor_t * p_cursor)
+{
+    p_cursor->p_block = NULL;
+
+    if (m_log.newest_page != FLASH_LOG_NO_PAGE)
+    {
+        (void)cursor_block_find(p_cursor, m_log.oldest_page, FLASH_LOG_HEADER_WORDS);
+    }
+}
+
+void flash_log_cursor_seek(flash_log_cursor_t * p_cursor, uint32_t timestamp)
+{
+    flash_log_cursor_t         next;
+    flash_log_sample_t const * p_sample;
+    uint32_t                   low  = 0;
+    uint32_t                   high;
+
+    flash_log_cursor_begin(p_cursor);
+    if (p_cursor->p_block == NULL)
+    {
+        return;
+    }
+
+    // The anchor of the first valid block at or after the start of each page serves as a
+    // sparse time index: binary search for the last page starting no later than the
+    // timestamp. Pages are counted from the oldest one.
+    high = (m_log.newest_page + m_log.page_count - m_log.oldest_page) % m_log.page_count + 1;
+    while (high - low > 1)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        uint32_t page   = (m_log.oldest_page + middle) % m_log.page_count;
+
+        if (cursor_block_find(&next, page, FLASH_LOG_HEADER_WORDS) &&
+            (next.p_block->timestamp <= timestamp))
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    if (low > 0)
+    {
+        (void)cursor_block_find(p_cursor,
+                                (m_log.oldest_page + low) % m_log.page_count,
+                                FLASH_LOG_HEADER_WORDS);
+    }
+
+    // Skip every block followed by a block that starts no later than the timestamp.
+    next = *p_cursor;
+    while (cursor_block_advance(&next) && (next.p_block->timestamp <= timestamp))
+    {
+        *p_cursor = next;
+    }
+
+    // Skip the older samples of the block the timestamp falls in.
+    next = *p_cursor;
+    while ((flash_log_cursor_next(&next, &p_sample) == FLASH_LOG_SUCCESS) &&
+           (p_sample->timestamp < timestamp))
+    {
+        *p_cursor = next;
+    }
+}
+
+bool flash_log_cursor_seek_position(flash_log_cursor_t * p_cursor, flash_log_position_t const * p_position)
+{
+    flash_log_block_t const * p_block;
+    uint32_t                  pages;
+    uint32_t                  page;
+    uint32_t                  i;
+
+    flash_log_cursor_begin(p_cursor);
+    if (p_cursor->p_block == NULL)
+    {
+        return false;
+    }
+
+    // The pages from the oldest to the newest carry consecutive sequence numbers; a page
+    // reclaimed since, or not yet started, falls outside.
+    pages = p_position->sequence - page_header_get(m_log.oldest_page)->sequence;
+    if (pages > (m_log.newest_page + m_log.page_count - m_log.oldest_page) % m_log.page_count)
+    {
+        return false;
+    }
+    page    = (m_log.oldest_page + pages) % m_log.page_count;
+    p_block = block_get(page, p_position->offset);
+    if ((p_block == NULL) ||
+        !FLASH_LOG_BLOCK_IS_VALID(p_block) ||
+        (p_position->index >= FLASH_LOG_BLOCK_SAMPLES(p_block)))
+    {
+        return false;
+    }
+
+    // Decode up to the sample itself, so the deltas of the block carry on from it.
+    (void)cursor_block_find(p_cursor, page, p_position->offset);
+    for (i = 0; i <= p_position->index; i++)
+    {
+        if (block_decode_next(p_cursor) != FLASH_LOG_SUCCESS)
+        {
+            flash_log_cursor_begin(p_cursor);
+            return false;
+        }
+    }
+    return true;
+}
+
+void flash_log_cursor_position_get(flash_log_cursor_t const * p_cursor, flash_log_position_t * p_position)
+{
+    p_position->sequence = page_header_get(p_cursor->page)->sequence;
+    p_position->offset   = (uint16_t)p_cursor->offset;
+    p_position->index    = (uint16_t)(FLASH_LOG_BLOCK_SAMPLES(p_cursor->p_block) - p_cursor->remaining - 1);
+}
+
+flash_log_ret_t flash_log_cursor_next(flash_log_cursor_t * p_cursor, flash_log_sample_t const ** pp_sample)
+{
+    flash_log_ret_t ret;
+
+    while (p_cursor->p_block != NULL)
+    {
+        ret = block_decode_next(p_cursor);
+        if (ret == FLASH_LOG_SUCCESS)
+        {
+            *pp_sample = &p_cursor->sample;
+            return FLASH_LOG_SUCCESS;
+        }
+        if (ret != FLASH_LOG_ERROR_NOT_FOUND)
+        {
+            return ret;
+        }
+        (void)cursor_block_advance(p_cursor);
+    }
+
+    return FLASH_LOG_ERROR_NOT_FOUND;
+}
+
+bool flash_log_cursor_time_uncertain(flash_log_cursor_t const * p_cursor)
+{
+    return (p_cursor->p_block != NULL) &&
+           (FLASH_LOG_BLOCK_MAGIC(p_cursor->p_block) == FLASH_LOG_BLOCK_UNCERTAIN);
+}
+
+flash_log_ret_t flash_log_cursor_block_next(flash_log_cursor_t * p_cursor, flash_log_block_t const ** pp_block)
+{
+    if ((p_cursor->p_block != NULL) && (p_cursor->remaining == 0))
+    {
+        (void)cursor_block_advance(p_cursor);
+    }
+    if (p_cursor->p_block == NULL)
+    {
+        return FLASH_LOG_ERROR_NOT_FOUND;
+    }
+
+    *pp_block = p_cursor->p_block;
+    (void)cursor_block_advance(p_cursor);
+    return FLASH_LOG_SUCCESS;
+}
+
+flash_log_ret_t flash_log_foreach(flash_log_sample_handler_t handler, void * p_context)
+{
+    flash_log_cursor_t         cursor;
+    flash_log_sample_t const * p_sample;
+    flash_log_ret_t            ret;
+
+    flash_log_cursor_begin(&cursor);
+    while ((ret = flash_log_cursor_next(&cursor, &p_sample)) == FLASH_LOG_SUCCESS)
+    {
+        handler(p_sample, p_context);
+    }
+
+    return (ret == FLASH_LOG_ERROR_NOT_FOUND) ? FLASH_LOG_SUCCESS : ret;
+}
+
+uint32_t flash_log_count(void)
+{
+    return m_log.count;
+}
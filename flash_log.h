@@ -0,0 +1,203 @@
+#ifndef FLASH_LOG_H__
+#define FLASH_LOG_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Append-only temperature log spanning a ring of flash pages.
+ *
+ * When the newest page fills up, the oldest page is erased and reused, so the log never
+ * stops recording. Every page keeps its own erase counter in its header, and a log that is
+ * erased as a whole restarts on the least worn page, so erases spread evenly over the region.
+ *
+ * Samples are stored in compressed blocks: an absolute anchor sample followed by one
+ * delta per sample. A steady series costs one byte per sample, see flash_log_block_t.
+ *
+ * The log engine only touches flash through the two flash_log_nvmc_* functions below,
+ * so it can be linked against the real NVMC (flash_log_nvmc.c) or against a simulated
+ * flash image when built as a host library.
+ */
+
+// Flash region reserved for the log. Must match the linker scripts, which end the
+// application FLASH region at FLASH_LOG_START_ADDR. The last pages of the reserved area
+// hold the checkpoint store, see checkpoint.h.
+#define FLASH_LOG_PAGE_SIZE         (4096u)
+#define FLASH_LOG_PAGE_COUNT        (30u)
+#define FLASH_LOG_START_ADDR        (0xE0000u)
+
+// Maximum number of samples in one block.
+#define FLASH_LOG_BLOCK_MAX_SAMPLES (64u)
+
+// Block states kept in the upper half-word of flash_log_block_t::value. A block is never
+// rewritten once valid; a block torn by a reset is moved to the discarded state by
+// clearing bits only. Blocks appended while the time is uncertain, see
+// flash_log_time_uncertain_set(), are valid but carry their own state.
+#define FLASH_LOG_BLOCK_NOT_INIT    (0xFFFF)
+#define FLASH_LOG_BLOCK_VALID       (0xA55A)
+#define FLASH_LOG_BLOCK_UNCERTAIN   (0xA51A)
+#define FLASH_LOG_BLOCK_DISCARDED   (0x0000)
+
+typedef enum
+{
+    FLASH_LOG_SUCCESS,
+    FLASH_LOG_ERROR_CORRUPTED,  /**< Unexpected data found in the log region. */
+    FLASH_LOG_ERROR_NOT_FOUND,  /**< Requested record does not exist. */
+    FLASH_LOG_ERROR_INVALID_PARAM, /**< Argument out of range. */
+} flash_log_ret_t;
+
+typedef struct
+{
+    uint32_t timestamp;         /**< Seconds since the epoch. */
+    int32_t  temperature;       /**< Temperature in 0.25 °C units. */
+} flash_log_sample_t;
+
+/**
+ * @brief Compressed block of samples as stored in flash.
+ *
+ * The header holds the first sample in full and the time to the second sample. Every
+ * following sample is encoded relative to its predecessor as the change of sampling
+ * interval (delta of the time delta) and the change of temperature:
+ * - one byte 0b0ddttttt when the interval changes by -2..1 s (dd) and the temperature by
+ *   -16..15 quarter degrees (ttttt), both two's complement;
+ * - otherwise the byte 0x80 followed by both deltas as zig-zag varints.
+ *
+ * The payload is padded to a word boundary with erased bytes. Everything but the value
+ * word is programmed first, the value word last, so a block only becomes valid once it
+ * is complete.
+ */
+typedef struct
+{
+    uint32_t value;             /**< State << 16 | anchor temperature (signed half-word). */
+    uint32_t timestamp;         /**< Anchor timestamp. */
+    uint32_t size;              /**< Initial interval (12 bits) | number of samples (8 bits) |
+                                     payload length in bytes (12 bits). */
+} flash_log_block_t;
+
+#define FLASH_LOG_BLOCK_MAGIC(p_block)      ((uint16_t)((p_block)->value >> 16))
+#define FLASH_LOG_BLOCK_IS_VALID(p_block)   ((FLASH_LOG_BLOCK_MAGIC(p_block) == FLASH_LOG_BLOCK_VALID) || \
+                                             (FLASH_LOG_BLOCK_MAGIC(p_block) == FLASH_LOG_BLOCK_UNCERTAIN))
+#define FLASH_LOG_BLOCK_INTERVAL(p_block)   ((p_block)->size >> 20)
+#define FLASH_LOG_BLOCK_SAMPLES(p_block)    (((p_block)->size >> 12) & 0x000000FF)
+#define FLASH_LOG_BLOCK_LENGTH(p_block)     ((p_block)->size & 0x00000FFF)
+#define FLASH_LOG_BLOCK_SIZE(interval, samples, length) \
+    (((uint32_t)(interval) << 20) | ((uint32_t)(samples) << 12) | (uint32_t)(length))
+#define FLASH_LOG_BLOCK_MAX_INTERVAL        (0x00000FFF)
+
+#define FLASH_LOG_PAGE_MAGIC        (0x4C47) // "LG"
+
+/**
+ * @brief Header at the start of every page.
+ *
+ * The info word (magic number and erase counter) is written right after the page is
+ * erased, which makes the page free. The sequence number is written when the page joins
+ * the log, and the sample count once the page is full. Pages join the ring in order of
+ * increasing sequence number, which lets the log head be found by binary search.
+ */
+typedef struct
+{
+    uint32_t sequence;          /**< Erased while the page is free. */
+    uint32_t info;              /**< FLASH_LOG_PAGE_MAGIC << 16 | erase counter. */
+    uint32_t samples;           /**< Valid samples in the page, erased until the page is full. */
+    uint32_t reserved;
+} flash_log_page_header_t;
+
+#define FLASH_LOG_PAGE_INFO(erase_count)    (((uint32_t)FLASH_LOG_PAGE_MAGIC << 16) | (uint16_t)(erase_count))
+
+/**
+ * @brief Read position in the log.
+ *
+ * The cursor points straight into the memory-mapped log region and decodes samples in
+ * place, so reading needs no copy of the flash data. The cursor is invalidated by any
+ * append or erase that recycles the page it points to.
+ */
+typedef struct
+{
+    flash_log_block_t const * p_block;      /**< Current block in flash, NULL past the end of the log. */
+    uint32_t                  page;         /**< Page holding the current block. */
+    uint32_t                  offset;       /**< Offset in words of the current block in its page. */
+    uint8_t const           * p_data;       /**< Next payload byte of the current block. */
+    uint32_t                  remaining;    /**< Samples of the current block not yet returned. */
+    int32_t                   interval;     /**< Time delta between the last two samples. */
+    flash_log_sample_t        sample;       /**< Last returned sample. */
+} flash_log_cursor_t;
+
+/**
+ * @brief Position of a sample in the log, independent of its timestamp.
+ *
+ * Pages join the log with consecutive sequence numbers and blocks never move within their
+ * page, so a position stays valid until its page is reclaimed or the log is erased, which
+ * starts the sequence numbers over.
+ */
+typedef struct
+{
+    uint32_t sequence;          /**< Sequence number of the page. */
+    uint16_t offset;            /**< Offset in words of the block in its page. */
+    uint16_t index;             /**< Index of the sample in its block. */
+} flash_log_position_t;
+
+// Called for every sample by flash_log_foreach(), oldest first.
+typedef void (*flash_log_sample_handler_t)(flash_log_sample_t const * p_sample, void * p_context);
+
+// Initializes the log over page_count (at least 2) pages starting at p_region and locates
+// the log head. Returns FLASH_LOG_ERROR_CORRUPTED if the region holds something other than
+// log data; call flash_log_erase() to recover.
+flash_log_ret_t flash_log_init(uint32_t * p_region, uint32_t page_count);
+
+// Discards the whole log. Only pages holding data are erased; erase counters are kept.
+void flash_log_erase(void);
+
+// Appends count samples as one or more compressed blocks, reclaiming the oldest page if needed.
+flash_log_ret_t flash_log_append_batch(flash_log_sample_t const * p_samples, uint32_t count);
+
+// Marks the blocks appended from now on as holding timestamps that cannot be trusted, e.g.
+// taken by a clock restored after a reset that lost the time. Off after a reset.
+void flash_log_time_uncertain_set(bool uncertain);
+
+// Appends one sample as a block of its own. Prefer flash_log_append_batch().
+flash_log_ret_t flash_log_append(flash_log_sample_t const * p_sample);
+
+// Decodes every sample in the log, oldest first, using a cursor.
+flash_log_ret_t flash_log_foreach(flash_log_sample_handler_t handler, void * p_context);
+
+// Places the cursor before the oldest sample.
+void flash_log_cursor_begin(flash_log_cursor_t * p_cursor);
+
+// Places the cursor before the first sample with a timestamp not older than the given one.
+// Pages are located by binary search on their first block, then blocks by their anchor.
+// Timestamps are expected to increase along the log.
+void flash_log_cursor_seek(flash_log_cursor_t * p_cursor, uint32_t timestamp);
+
+// Places the cursor after the sample at the given position, taken by
+// flash_log_cursor_position_get(). Returns false and places the cursor before the oldest
+// sample if the position is no longer in the log.
+bool flash_log_cursor_seek_position(flash_log_cursor_t * p_cursor, flash_log_position_t const * p_position);
+
+// Takes the position of the sample last returned by flash_log_cursor_next().
+void flash_log_cursor_position_get(flash_log_cursor_t const * p_cursor, flash_log_position_t * p_position);
+
+// Decodes the next sample. *pp_sample points into the cursor and stays valid until the
+// next call. Returns FLASH_LOG_ERROR_NOT_FOUND past the newest sample.
+flash_log_ret_t flash_log_cursor_next(flash_log_cursor_t * p_cursor, flash_log_sample_t const ** pp_sample);
+
+// Returns true if the timestamp of the sample last returned by flash_log_cursor_next() is
+// uncertain.
+bool flash_log_cursor_time_uncertain(flash_log_cursor_t const * p_cursor);
+
+// Returns the flash block holding the next sample and moves the cursor past that block.
+// Returns FLASH_LOG_ERROR_NOT_FOUND past the newest block.
+flash_log_ret_t flash_log_cursor_block_next(flash_log_cursor_t * p_cursor, flash_log_block_t const ** pp_block);
+
+// Returns the number of samples stored in the log.
+uint32_t flash_log_count(void);
+
+// Returns how many times the given page of the log region has been erased.
+uint32_t flash_log_erase_count_get(uint32_t page);
+
+// Flash access used by the log and the checkpoint store. Implemented for the NVMC in
+// flash_log_nvmc.c.
+void flash_log_nvmc_write_words(uint32_t * p_dst, uint32_t const * p_src, size_t num_words);
+void flash_log_nvmc_page_erase(uint32_t * p_page);
+
+#endif // FLASH_LOG_H__
@@ -0,0 +1,12 @@
+#include "flash_log.h"
+#include "nrf_nvmc.h"
+
+void flash_log_nvmc_write_words(uint32_t * p_dst, uint32_t const * p_src, size_t num_words)
+{
+    nrf_nvmc_write_words((uint32_t)p_dst, p_src, num_words);
+}
+
+void flash_log_nvmc_page_erase(uint32_t * p_page)
+{
+    nrf_nvmc_page_erase((uint32_t)p_page);
+}
@@ -0,0 +1,135 @@
+#include <string.h>
+#include "gateway.h"
+
+// Finds the entry of a device, or takes a free or the stalest slot for it.
+static gateway_device_t * device_get(gateway_t * p_gateway, uint32_t device_id)
+{
+    gateway_device_t * p_stalest = NULL;
+    uint32_t           slot      = (device_id * 2654435761u) % GATEWAY_MAX_DEVICES;
+    uint32_t           i;
+
+    for (i = 0; i < GATEWAY_PROBE_LIMIT; i++)
+    {
+        gateway_device_t * p_device = &p_gateway->devices[(slot + i) % GATEWAY_MAX_DEVICES];
+
+        if (!p_device->used)
+        {
+            p_gateway->device_count++;
+            p_stalest = p_device;
+            break;
+        }
+        if (p_device->device_id == device_id)
+        {
+            return p_device;
+        }
+        if ((p_stalest == NULL) ||
+            (p_gateway->packets - p_device->last_heard > p_gateway->packets - p_stalest->last_heard))
+        {
+            p_stalest = p_device;
+        }
+    }
+
+    if (p_stalest->used)
+    {
+        p_gateway->evictions++;
+    }
+    memset(p_stalest, 0, sizeof(*p_stalest));
+    p_stalest->used      = true;
+    p_stalest->device_id = device_id;
+    return p_stalest;
+}
+
+// Returns true if the sequence number was not seen before, and records it.
+static bool sequence_check(gateway_device_t * p_device, uint32_t sequence, bool known)
+{
+    uint32_t ahead  = sequence - p_device->sequence;
+    uint32_t behind = p_device->sequence - sequence;
+
+    if (known && (sequence == p_device->sequence))
+    {
+        return false;
+    }
+
+    if (known && (behind <= GATEWAY_WINDOW_SIZE))
+    {
+        if (p_device->window & (1u << (behind - 1)))
+        {
+            return false;
+        }
+        p_device->window |= 1u << (behind - 1);
+        return true;
+    }
+
+    // Ahead of the window, or so far behind that the logger must have restarted.
+    if (known && ((int32_t)ahead > 0) && (ahead <= GATEWAY_WINDOW_SIZE))
+    {
+        p_device->window = (ahead < 32) ? ((p_device->window << ahead) | (1u << (ahead - 1))) : (1u << 31);
+    }
+    else
+    {
+        p_device->window = 0;
+    }
+    p_device->sequence = sequence;
+    return true;
+}
+
+void gateway_init(gateway_t * p_gateway, gateway_sample_handler_t handler, void * p_context)
+{
+    memset(p_gateway, 0, sizeof(*p_gateway));
+    p_gateway->handler   = handler;
+    p_gateway->p_context = p_context;
+}
+
+gateway_frame_t gateway_packet_put(gateway_t            * p_gateway,
+                                   uint8_t const        * p_packet,
+                                   uint32_t               size,
+                                   radio_frame_header_t * p_header)
+{
+    gateway_device_t * p_device;
+    flash_log_sample_t sample;
+    bool               known;
+    uint32_t           repeated = 0;
+    uint32_t           i;
+
+    p_gateway->packets++;
+    if (!radio_frame_decode(p_packet, size, p_header) || (p_header->type != RADIO_FRAME_TYPE_SAMPLES))
+    {
+        p_gateway->invalid++;
+        return GATEWAY_FRAME_INVALID;
+    }
+
+    p_device = device_get(p_gateway, p_header->device_id);
+    known    = (p_device->last_heard != 0);
+    p_device->last_heard = p_gateway->packets;
+    if (!sequence_check(p_device, p_header->sequence, known))
+    {
+        p_gateway->duplicates++;
+        return GATEWAY_FRAME_DUPLICATE;
+    }
+
+    // A resumed transfer starts again at the first sample of the frame it lost the ACK of.
+    if (p_device->has_samples && (p_header->timestamp == p_device->frame_timestamp))
+    {
+        repeated = (p_header->count < p_device->frame_count) ? p_header->count : p_device->frame_count;
+    }
+    p_device->frame_timestamp = p_header->timestamp;
+    p_device->frame_count     = p_header->count;
+    p_device->has_samples     = true;
+
+    p_gateway->frames++;
+    p_gateway->repeated += repeated;
+    for (i = repeated; i < p_header->count; i++)
+    {
+        radio_frame_sample_get(p_packet, p_header, i, &sample);
+        p_gateway->samples++;
+        if (p_gateway->handler != NULL)
+        {
+            p_gateway->handler(p_header->device_id,
+                               &sample,
+                               (p_header->flags & RADIO_FRAME_FLAG_TIME_UNCERTAIN) != 0,
+                               p_gateway->p_context);
+        }
+    }
+
+    return GATEWAY_FRAME_NEW;
+}
@@ -0,0 +1,84 @@
+#ifndef GATEWAY_H__
+#define GATEWAY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_log.h"
+#include "radio_frame.h"
+
+/**
+ * @brief Receiving end of the radio transfer: decodes frames and drops what was seen.
+ *
+ * Loggers send every frame until it is acknowledged, so a gateway sees the same frame
+ * more than once whenever an ACK is lost. Per device, the gateway therefore remembers the
+ * newest sequence number with a window of the GATEWAY_WINDOW_SIZE before it: a frame
+ * already in the window is a duplicate. A sequence number far behind the window means the
+ * logger restarted with a new random sequence.
+ *
+ * A transfer resumed after its last frame went unacknowledged starts again at the first
+ * sample of that frame, under a new sequence number. The gateway also remembers the base
+ * timestamp and sample count of the newest frame: a new frame with the same base timestamp
+ * repeats that many samples at its start, which are dropped. Any other frame is delivered
+ * whole, so samples are kept when the logger's clock was set back.
+ *
+ * Devices live in an open-addressing table. When the GATEWAY_PROBE_LIMIT slots a new
+ * device may take are all in use, the one heard from longest ago is forgotten.
+ *
+ * Plain C without hardware dependencies, shared by the firmware and tools/gateway.
+ */
+
+#define GATEWAY_MAX_DEVICES         (256u)      /**< Power of two. */
+#define GATEWAY_PROBE_LIMIT         (8u)
+#define GATEWAY_WINDOW_SIZE         (32u)
+
+typedef enum
+{
+    GATEWAY_FRAME_NEW,              /**< Sample frame seen for the first time. */
+    GATEWAY_FRAME_DUPLICATE,        /**< Sample frame seen before; acknowledge it again. */
+    GATEWAY_FRAME_INVALID           /**< Not a well-formed sample frame. */
+} gateway_frame_t;
+
+// Called with every sample delivered, oldest first per device.
+typedef void (*gateway_sample_handler_t)(uint32_t                   device_id,
+                                         flash_log_sample_t const * p_sample,
+                                         bool                       uncertain,
+                                         void                     * p_context);
+
+typedef struct
+{
+    uint32_t device_id;
+    uint32_t sequence;              /**< Newest sequence number seen. */
+    uint32_t window;                /**< Bit n is set if sequence - 1 - n was seen. */
+    uint32_t frame_timestamp;       /**< Base timestamp of the newest frame, if has_samples. */
+    uint32_t frame_count;           /**< Samples in that frame. */
+    uint32_t last_heard;            /**< Value of gateway_t::packets at the newest frame. */
+    bool     used;
+    bool     has_samples;
+} gateway_device_t;
+
+typedef struct
+{
+    gateway_device_t         devices[GATEWAY_MAX_DEVICES];
+    gateway_sample_handler_t handler;
+    void                   * p_context;
+    uint32_t                 packets;       /**< Packets put. */
+    uint32_t                 invalid;
+    uint32_t                 duplicates;
+    uint32_t                 frames;        /**< New sample frames. */
+    uint32_t                 samples;       /**< Samples delivered. */
+    uint32_t                 repeated;      /**< Samples dropped as repeated by a resumed transfer. */
+    uint32_t                 device_count;  /**< Devices in the table. */
+    uint32_t                 evictions;
+} gateway_t;
+
+// Clears the gateway. handler may be NULL if only the frame verdicts are of interest.
+void gateway_init(gateway_t * p_gateway, gateway_sample_handler_t handler, void * p_context);
+
+// Takes a received packet. The header of a sample frame is copied to p_header, also for
+// duplicates, so the ACK can be built from it.
+gateway_frame_t gateway_packet_put(gateway_t            * p_gateway,
+                                   uint8_t const        * p_packet,
+                                   uint32_t               size,
+                                   radio_frame_header_t * p_header);
+
+#endif // GATEWAY_H__
@@ -0,0 +1,164 @@
+#include "log_dump.h"
+#include <string.h>
+#include "flash_log.h"
+
+static uint8_t m_frame[LOG_DUMP_FRAME_MAX_SIZE];   /**< Frame being sent, in RAM for EasyDMA. */
+
+uint16_t log_dump_crc16(uint8_t const * p_data, size_t length, uint16_t crc)
+{
+    size_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        crc  = (uint8_t)(crc >> 8) | (crc << 8);
+        crc ^= p_data[i];
+        crc ^= (uint8_t)(crc & 0xFF) >> 4;
+        crc ^= (crc << 8) << 4;
+        crc ^= ((crc & 0xFF) << 4) << 1;
+    }
+
+    return crc;
+}
+
+uint32_t log_dump_word_get(uint8_t const * p_data)
+{
+    return (uint32_t)p_data[0]         |
+           ((uint32_t)p_data[1] << 8)  |
+           ((uint32_t)p_data[2] << 16) |
+           ((uint32_t)p_data[3] << 24);
+}
+
+static void word_put(uint8_t * p_data, uint32_t word)
+{
+    p_data[0] = (uint8_t)word;
+    p_data[1] = (uint8_t)(word >> 8);
+    p_data[2] = (uint8_t)(word >> 16);
+    p_data[3] = (uint8_t)(word >> 24);
+}
+
+// Completes the frame in m_frame, whose payload is already in place, and sends it.
+static uint32_t frame_send(uint8_t type, uint16_t length, log_dump_write_t write, void * p_context)
+{
+    uint16_t crc;
+
+    m_frame[0] = LOG_DUMP_SYNC;
+    m_frame[1] = type;
+    m_frame[2] = (uint8_t)length;
+    m_frame[3] = (uint8_t)(length >> 8);
+
+    crc = log_dump_crc16(&m_frame[1], LOG_DUMP_HEADER_SIZE - 1 + length, 0xFFFF);
+    m_frame[LOG_DUMP_HEADER_SIZE + length]     = (uint8_t)crc;
+    m_frame[LOG_DUMP_HEADER_SIZE + length + 1] = (uint8_t)(crc >> 8);
+
+    length += LOG_DUMP_HEADER_SIZE + LOG_DUMP_CRC_SIZE;
+    write(m_frame, length, p_context);
+    return length;
+}
+
+static bool chunk_is_erased(uint32_t const * p_chunk)
+{
+    uint32_t i;
+
+    for (i = 0; i < LOG_DUMP_CHUNK_SIZE / sizeof(uint32_t); i++)
+    {
+        if (p_chunk[i] != 0xFFFFFFFF)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint32_t log_dump_region(uint32_t const * p_region,
+                         uint32_t         page_count,
+                         log_dump_write_t write,
+                         void           * p_context)
+{
+    uint8_t * p_payload = &m_frame[LOG_DUMP_HEADER_SIZE];
+    uint32_t  size      = page_count * FLASH_LOG_PAGE_SIZE;
+    uint32_t  frames    = 0;
+    uint32_t  sent      = 0;
+    uint32_t  offset;
+
+    word_put(&p_payload[0], FLASH_LOG_PAGE_SIZE);
+    word_put(&p_payload[4], page_count);
+    sent += frame_send(LOG_DUMP_FRAME_START, 8, write, p_context);
+
+    for (offset = 0; offset < size; offset += LOG_DUMP_CHUNK_SIZE)
+    {
+        uint32_t const * p_chunk = p_region + offset / sizeof(uint32_t);
+
+        // Free pages and the unused tail of the newest page are skipped.
+        if (chunk_is_erased(p_chunk))
+        {
+            continue;
+        }
+
+        word_put(&p_payload[0], offset);
+        memcpy(&p_payload[4], p_chunk, LOG_DUMP_CHUNK_SIZE);
+        sent += frame_send(LOG_DUMP_FRAME_DATA, LOG_DUMP_PAYLOAD_MAX_SIZE, write, p_context);
+        frames++;
+    }
+
+    word_put(&p_payload[0], frames);
+    sent += frame_send(LOG_DUMP_FRAME_END, 4, write, p_context);
+
+    return sent;
+}
+
+uint32_t log_dump_packet(uint8_t const * p_packet, uint32_t size, log_dump_write_t write, void * p_context)
+{
+    if (size > LOG_DUMP_PAYLOAD_MAX_SIZE)
+    {
+        return 0;
+    }
+
+    memcpy(&m_frame[LOG_DUMP_HEADER_SIZE], p_packet, size);
+    return frame_send(LOG_DUMP_FRAME_PACKET, (uint16_t)size, write, p_context);
+}
+
+size_t log_dump_frame_parse(uint8_t const * p_data, size_t length, log_dump_frame_t * p_frame, bool * p_more)
+{
+    uint16_t payload_length;
+    uint16_t crc;
+    size_t   frame_length;
+
+    *p_more = false;
+
+    if ((length > 0) && (p_data[0] != LOG_DUMP_SYNC))
+    {
+        return 0;
+    }
+    if (length < LOG_DUMP_HEADER_SIZE)
+    {
+        *p_more = true;
+        return 0;
+    }
+
+    payload_length = (uint16_t)(p_data[2] | (p_data[3] << 8));
+    if (payload_length > LOG_DUMP_PAYLOAD_MAX_SIZE)
+    {
+        return 0;
+    }
+
+    frame_length = LOG_DUMP_HEADER_SIZE + payload_length + LOG_DUMP_CRC_SIZE;
+    if (length < frame_length)
+    {
+        *p_more = true;
+        return 0;
+    }
+
+    crc = log_dump_crc16(&p_data[1], LOG_DUMP_HEADER_SIZE - 1 + payload_length, 0xFFFF);
+    if ((p_data[frame_length - 2] != (uint8_t)crc) ||
+        (p_data[frame_length - 1] != (uint8_t)(crc >> 8)))
+    {
+        return 0;
+    }
+
+    p_frame->type      = p_data[1];
+    p_frame->length    = payload_length;
+    p_frame->p_payload = &p_data[LOG_DUMP_HEADER_SIZE];
+
+    return frame_length;
+}
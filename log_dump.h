@@ -0,0 +1,74 @@
+#ifndef LOG_DUMP_H__
+#define LOG_DUMP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Framed binary dump of the flash log region.
+ *
+ * The raw log pages are streamed as a sequence of frames:
+ *
+ *   sync (0xA5) | type | payload length (16 bit) | payload | CRC-16 (16 bit)
+ *
+ * All multi-byte fields are little endian. The CRC (CCITT, initial value 0xFFFF) covers
+ * the type, length and payload. A dump is one START frame, any number of DATA frames and
+ * one END frame. Chunks that are fully erased are not sent; the receiver starts from an
+ * erased image, mounts it with flash_log_init() and decodes it like the device does.
+ *
+ * The same framing carries the radio packets a gateway receives, one PACKET frame each,
+ * to tools/gateway.
+ *
+ * This module is plain C and is shared by the firmware and the host tool in tools/.
+ */
+
+#define LOG_DUMP_SYNC               (0xA5)
+#define LOG_DUMP_CHUNK_SIZE         (1024u)     /**< Region bytes carried by one DATA frame. */
+
+#define LOG_DUMP_HEADER_SIZE        (4u)
+#define LOG_DUMP_CRC_SIZE           (2u)
+#define LOG_DUMP_PAYLOAD_MAX_SIZE   (sizeof(uint32_t) + LOG_DUMP_CHUNK_SIZE)
+#define LOG_DUMP_FRAME_MAX_SIZE     (LOG_DUMP_HEADER_SIZE + LOG_DUMP_PAYLOAD_MAX_SIZE + LOG_DUMP_CRC_SIZE)
+
+typedef enum
+{
+    LOG_DUMP_FRAME_START  = 'S',    /**< Payload: page size, page count. */
+    LOG_DUMP_FRAME_DATA   = 'D',    /**< Payload: byte offset in the region, region bytes. */
+    LOG_DUMP_FRAME_END    = 'E',    /**< Payload: number of DATA frames sent. */
+    LOG_DUMP_FRAME_PACKET = 'P',    /**< Payload: a radio packet, see radio_frame.h. */
+} log_dump_frame_type_t;
+
+typedef struct
+{
+    uint8_t         type;           /**< One of log_dump_frame_type_t. */
+    uint16_t        length;         /**< Payload length in bytes. */
+    uint8_t const * p_payload;      /**< Points into the buffer passed to log_dump_frame_parse(). */
+} log_dump_frame_t;
+
+// Called with every frame of the dump. The frame buffer is reused after the call returns.
+typedef void (*log_dump_write_t)(uint8_t const * p_data, size_t length, void * p_context);
+
+// Streams page_count pages starting at p_region. Every chunk is copied to a RAM frame
+// buffer first, so write may hand it to EasyDMA, which cannot read flash.
+// Returns the number of bytes written.
+uint32_t log_dump_region(uint32_t const * p_region,
+                         uint32_t         page_count,
+                         log_dump_write_t write,
+                         void           * p_context);
+
+// Sends a radio packet of up to LOG_DUMP_PAYLOAD_MAX_SIZE bytes as a PACKET frame.
+// Returns the number of bytes written.
+uint32_t log_dump_packet(uint8_t const * p_packet, uint32_t size, log_dump_write_t write, void * p_context);
+
+// Looks for a valid frame at the start of p_data. Returns the size of the frame, or 0 if
+// p_data does not start with a valid frame. Sets *p_more if more data could complete it.
+size_t log_dump_frame_parse(uint8_t const * p_data, size_t length, log_dump_frame_t * p_frame, bool * p_more);
+
+// Returns the little-endian word at p_data.
+uint32_t log_dump_word_get(uint8_t const * p_data);
+
+// CRC-16/CCITT. Pass 0xFFFF as crc for the first block of data.
+uint16_t log_dump_crc16(uint8_t const * p_data, size_t length, uint16_t crc);
+
+#endif // LOG_DUMP_H__
@@ -1,7 +1,8 @@
 #include <stdbool.h>
 #include <stdio.h>
-#include <time.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include "nrf.h"
 #include "app_error.h"
 #include "nrf_nvmc.h"
@@ -13,108 +14,153 @@
 #include "nrf_log_default_backends.h"
 
 #include "app_timer.h"
+#include "app_scheduler.h"
+#include "nrf_pwr_mgmt.h"
 #include "nrf_drv_clock.h"
 
 #include "nrf_cli.h"
 #include "nrf_cli_uart.h"
-#include "nrf_temp.h"
 
 #include "nrf_calendar.h"
-
-#define FLASHWRITE_EXAMPLE_MAX_STRING_LEN       (62u)
-#define FLASHWRITE_EXAMPLE_BLOCK_VALID          (0xA55A5AA5)
-#define FLASHWRITE_EXAMPLE_BLOCK_INVALID        (0xA55A0000)
-#define FLASHWRITE_EXAMPLE_BLOCK_NOT_INIT       (0xFFFFFFFF)
-
-static uint32_t packet;                    /**< Packet to transmit. */
+#include "civil_time.h"
+#include "flash_log.h"
+#include "temp_sensor.h"
+#include "temp_logger.h"
+#include "log_dump.h"
+#include "checkpoint.h"
+#include "trip_summary.h"
+#include "calendar_backup.h"
+#include "gateway.h"
+#include "radio_config.h"
+#include "radio_frame.h"
+#include "radio_link.h"
+#include "radio_tx.h"
+
+#define SCHED_MAX_EVENT_DATA_SIZE   sizeof(int32_t)    /**< Largest scheduler event payload. */
+#define SCHED_QUEUE_SIZE            8                  /**< Maximum number of pending scheduler events. */
+
+#define GATEWAY_FIFO_SIZE           8                  /**< Received frames waiting for the UART. */
+#define SEND_COUNT_MAX              (FLASH_LOG_PAGE_COUNT * FLASH_LOG_PAGE_SIZE) /**< Above any log size: a sample takes a byte or more. */
+
+// Log transfer over the radio, driven from the scheduler as ACKs arrive or reply windows close.
+static radio_link_t      m_link;
+static uint32_t          m_reply_timeout;           /**< Reply window in calendar ticks. */
+static uint8_t           m_reply[RADIO_FRAME_MAX_SIZE];
+static volatile uint32_t m_reply_size;              /**< Size of m_reply, 0 if no reply came. */
+static bool              m_resume_valid = false;    /**< m_resume is set. */
+static struct
+{
+    flash_log_position_t position;                  /**< Newest sample acknowledged by a receiver. */
+    uint32_t             timestamp;                 /**< Its timestamp, for display. */
+} m_resume;
+
+// Gateway mode: acknowledges the frames of other loggers and streams the new ones to
+// tools/gateway as PACKET frames.
+static gateway_t         m_gateway;
+static bool              m_gateway_on = false;
+static nrf_cli_t const * mp_gateway_cli;
+static uint8_t           m_gateway_fifo[GATEWAY_FIFO_SIZE][1 + RADIO_FRAME_MAX_SIZE];
+static volatile uint32_t m_gateway_head = 0;        /**< Frames streamed, advanced by the scheduler. */
+static volatile uint32_t m_gateway_tail = 0;        /**< Frames received, advanced by the RADIO interrupt. */
+static volatile uint32_t m_gateway_overflows = 0;   /**< Frames left unacknowledged for lack of room. */
+static volatile bool     m_gateway_scheduled = false;
 
 static bool run_time_updates = false;
 
-NRF_CLI_UART_DEF(m_cli_uart_transport, 0, 64, 16);
-NRF_CLI_DEF(m_cli_uart, "uart_cli:~$ ", &m_cli_uart_transport.transport, '\r', 4);
-
-typedef struct
-{
-   uint32_t magic_number;
-   uint32_t buffer[FLASHWRITE_EXAMPLE_MAX_STRING_LEN + 1]; // + 1 for end of string
-} flashwrite_example_flash_data_t;
+static uint64_t m_idle_ticks  = 0;         /**< RTC1 ticks spent in System ON idle since the last report. */
+static uint64_t m_total_ticks = 0;         /**< RTC1 ticks elapsed since the last report. */
+static uint32_t m_last_tick   = 0;
 
-typedef struct
-{
-    uint32_t addr;
-    uint32_t pg_size;
-    uint32_t pg_num;
-    flashwrite_example_flash_data_t * m_p_flash_data;
-} flashwrite_example_data_t;
-
-static flashwrite_example_data_t m_data;
+NRF_CLI_UART_DEF(m_cli_uart_transport, 0, 256, 16);
+NRF_CLI_DEF(m_cli_uart, "uart_cli:~$ ", &m_cli_uart_transport.transport, '\r', 4);
 
-static void flash_page_init(void)
+// Returns a word from the hardware random number generator.
+static uint32_t random_word_get(void)
 {
-    m_data.pg_num = NRF_FICR->CODESIZE - 1;
-    m_data.pg_size = NRF_FICR->CODEPAGESIZE;
-    m_data.addr = (m_data.pg_num * m_data.pg_size);
-
-    m_data.m_p_flash_data = (flashwrite_example_flash_data_t *)m_data.addr;
+    uint32_t word = 0;
+    uint32_t i;
 
-    while (1)
+    NRF_RNG->CONFIG = RNG_CONFIG_DERCEN_Enabled << RNG_CONFIG_DERCEN_Pos;
+    NRF_RNG->TASKS_START = 1;
+    for (i = 0; i < sizeof(word); i++)
     {
-        if (m_data.m_p_flash_data->magic_number == FLASHWRITE_EXAMPLE_BLOCK_VALID)
+        NRF_RNG->EVENTS_VALRDY = 0;
+        while (NRF_RNG->EVENTS_VALRDY == 0)
         {
-            return;
-        }
-
-        if (m_data.m_p_flash_data->magic_number == FLASHWRITE_EXAMPLE_BLOCK_INVALID)
-        {
-            ++m_data.m_p_flash_data;
-            continue;
+            // wait
         }
-
-        nrf_nvmc_page_erase(m_data.addr);
-        return;
+        word = (word << 8) | NRF_RNG->VALUE;
     }
+    NRF_RNG->TASKS_STOP = 1;
+
+    return word;
 }
 
-void send_packet()
+static void send_job_evt(void * p_event_data, uint16_t event_size);
+
+// Copies the reply for the scheduler, where the transfer goes on.
+static void radio_reply_handler(uint8_t const * p_packet, uint32_t size)
 {
-	// send the packet:
-	NRF_RADIO->EVENTS_READY = 0U;
-	NRF_RADIO->TASKS_TXEN   = 1;
+    memcpy(m_reply, p_packet, size);
+    m_reply_size = size;
+    APP_ERROR_CHECK(app_sched_event_put(NULL, 0, send_job_evt));
+}
 
-	while (NRF_RADIO->EVENTS_READY == 0U)
-	{
-		// wait
-	}
-	NRF_RADIO->EVENTS_END  = 0U;
-	NRF_RADIO->TASKS_START = 1U;
+// Returns true while the radio is in use: by a transfer, its last reply window or the
+// gateway mode.
+static bool radio_busy(void)
+{
+    return m_gateway_on || (m_link.state == RADIO_LINK_BUSY) || (radio_tx_pending() > 0);
+}
 
-	while (NRF_RADIO->EVENTS_END == 0U)
-	{
-		// wait
-	}
+// Sends the next frame of the transfer, or records how far it got once it is over.
+static void send_next(void)
+{
+    uint8_t const * p_frame;
+    uint32_t        size;
 
-	NRF_RADIO->EVENTS_DISABLED = 0U;
-	// Disable radio
-	NRF_RADIO->TASKS_DISABLE = 1U;
+    size = radio_link_frame_get(&m_link, &p_frame);
+    if (size > 0)
+    {
+        APP_ERROR_CHECK_BOOL(radio_tx_request(p_frame, size, m_reply_timeout, radio_reply_handler));
+        return;
+    }
 
-	while (NRF_RADIO->EVENTS_DISABLED == 0U)
-	{
-		// wait
-	}
+    if (m_link.acked)
+    {
+        m_resume.position  = m_link.acked_position;
+        m_resume.timestamp = m_link.acked_timestamp;
+        m_resume_valid     = true;
+        checkpoint_save(CHECKPOINT_KEY_RADIO, &m_resume, sizeof(m_resume));
+    }
+    if (m_link.state == RADIO_LINK_DONE)
+    {
+        NRF_LOG_INFO("Radio: all %u samples acknowledged.", m_link.samples_acked);
+    }
+    else
+    {
+        NRF_LOG_WARNING("Radio: no ACK, stopped after %u samples.", m_link.samples_acked);
+    }
+    NRF_LOG_INFO("Radio: %u frames sent, %u of them again.", m_link.frames_sent, m_link.retransmits);
 }
 
-void clock_initialization()
+static void send_job_evt(void * p_event_data, uint16_t event_size)
 {
-    /* Start 16 MHz crystal oscillator */
-    NRF_CLOCK->EVENTS_HFCLKSTARTED = 0;
-    NRF_CLOCK->TASKS_HFCLKSTART    = 1;
-
-    /* Wait for the external oscillator to start up */
-    while (NRF_CLOCK->EVENTS_HFCLKSTARTED == 0)
+    // The transfer may have been cancelled while the reply window was open.
+    if (m_link.state != RADIO_LINK_BUSY)
     {
-        // Do nothing.
+        return;
     }
 
+    // A missing or foreign reply leaves the frame unacknowledged, so it goes out again.
+    (void)radio_link_reply_put(&m_link, m_reply, m_reply_size);
+    send_next();
+}
+
+void clock_initialization()
+{
+    /* The high frequency crystal oscillator is only run by radio_tx while the radio is busy */
+
     /* Start low frequency crystal oscillator for app_timer(used by bsp)*/
     NRF_CLOCK->LFCLKSRC            = (CLOCK_LFCLKSRC_SRC_Xtal << CLOCK_LFCLKSRC_SRC_Pos);
     NRF_CLOCK->EVENTS_LFCLKSTARTED = 0;
@@ -126,6 +172,54 @@ void clock_initialization()
     }
 }
 
+/**
+ * @brief Function for handling fatal errors.
+ *
+ * @details Commits the samples staged in RAM before the reset would discard them, if the
+ *          fault was raised in thread mode.
+ */
+void app_error_fault_handler(uint32_t id, uint32_t pc, uint32_t info)
+{
+    // Only write flash from thread mode: a fault in an interrupt handler or a hard fault
+    // may have stopped an NVMC write or the log's bookkeeping halfway. Staged samples are
+    // lost in that case.
+    if ((SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) == 0)
+    {
+        UNUSED_RETURN_VALUE(temp_logger_flush());
+    }
+    NRF_LOG_FINAL_FLUSH();
+
+#ifndef DEBUG
+    NVIC_SystemReset();
+#else
+    app_error_save_and_stop(id, pc, info);
+#endif
+}
+
+/**
+ * @brief Function for handling the idle state (main loop).
+ *
+ * @details Sleeps in System ON idle until the next RTC, UART or TEMP event, unless there
+ *          is a pending log entry to process, and accounts the time spent asleep.
+ */
+static void idle_state_handle(void)
+{
+    uint32_t now;
+
+    if (NRF_LOG_PROCESS() == false)
+    {
+        uint32_t sleep_start = app_timer_cnt_get();
+
+        nrf_pwr_mgmt_run();
+        m_idle_ticks += app_timer_cnt_diff_compute(app_timer_cnt_get(), sleep_start);
+    }
+
+    // RTC1 wraps after 1024 s, the calendar wakes the loop far more often than that.
+    now = app_timer_cnt_get();
+    m_total_ticks += app_timer_cnt_diff_compute(now, m_last_tick);
+    m_last_tick = now;
+}
+
 /**
  * @brief Function for application main entry.
  */
@@ -138,19 +232,38 @@ int main(void)
     err_code = app_timer_init();
     APP_ERROR_CHECK(err_code);
 
+    APP_SCHED_INIT(SCHED_MAX_EVENT_DATA_SIZE, SCHED_QUEUE_SIZE);
+
+    err_code = nrf_pwr_mgmt_init();
+    APP_ERROR_CHECK(err_code);
+
     clock_initialization();
     APP_ERROR_CHECK(err_code);
     nrf_cal_init();
+    temp_sensor_init();
     // Set radio configuration parameters
     radio_configure();
+    radio_tx_init(NULL);
+    radio_link_init(&m_link, NRF_FICR->DEVICEID[0], random_word_get());
+    gateway_init(&m_gateway, NULL, NULL);
 
-    NVIC_ClearPendingIRQ(RADIO_IRQn);
-    NVIC_SetPriority(RADIO_IRQn, 6);
-
-    // Set payload pointer
-    NRF_RADIO->PACKETPTR = (uint32_t)&packet;
-
-    flash_page_init();
+    bool log_erased = false;
+    if (flash_log_init((uint32_t *)FLASH_LOG_START_ADDR, FLASH_LOG_PAGE_COUNT) != FLASH_LOG_SUCCESS)
+    {
+        NRF_LOG_RAW_INFO("Flash log corrupted - erasing.\r\n");
+        flash_log_erase();
+        log_erased = true;
+    }
+    checkpoint_init((uint32_t *)CHECKPOINT_START_ADDR);
+    trip_summary_init();
+    // The page sequence numbers start over in an erased log, so a resume point into the
+    // old log could match a sample of the new one.
+    if (log_erased)
+    {
+        checkpoint_clear(CHECKPOINT_KEY_RADIO);
+    }
+    m_resume_valid = checkpoint_load(CHECKPOINT_KEY_RADIO, &m_resume, sizeof(m_resume));
+    calendar_backup_restore(trip_summary_excursion_get()->last_timestamp);
 
     nrf_drv_uart_config_t uart_config = NRF_DRV_UART_DEFAULT_CONFIG;
     uart_config.pseltxd = TX_PIN_NUMBER;
@@ -166,131 +279,484 @@ int main(void)
     NRF_LOG_RAW_INFO("Execute: <flash -h> for more information "
                      "or press the Tab button to see all available commands.\r\n");
 
+    temp_logger_init();
+    temp_logger_start(TEMP_LOGGER_DEFAULT_INTERVAL);
+    m_last_tick = app_timer_cnt_get();
+
     while (true)
     {
-        UNUSED_RETURN_VALUE(NRF_LOG_PROCESS());
+        app_sched_execute();
         nrf_cli_process(&m_cli_uart);
+        idle_state_handle();
+    }
+}
+
+// Formats a temperature in 0.25 °C units as degrees with two decimals.
+static void temperature_format(char * p_buf, size_t size, int32_t temperature)
+{
+    uint32_t abs_temperature = (temperature < 0) ? -temperature : temperature;
+
+    snprintf(p_buf,
+             size,
+             "%s%u.%02u",
+             (temperature < 0) ? "-" : "",
+             abs_temperature / 4,
+             (abs_temperature % 4) * 25);
+}
+
+// Uncertain timestamps are marked with a question mark.
+static void sample_print(nrf_cli_t const * p_cli, flash_log_sample_t const * p_sample, bool uncertain)
+{
+    char time_string[CIVIL_TIME_STRING_SIZE];
+    char temperature_string[16];
+
+    civil_time_format(p_sample->timestamp, time_string);
+    temperature_format(temperature_string, sizeof(temperature_string), p_sample->temperature);
+    nrf_cli_fprintf(p_cli,
+                    NRF_CLI_NORMAL,
+                    "%s%s: %s °C\r\n",
+                    time_string,
+                    uncertain ? "?" : "",
+                    temperature_string);
+}
+
+static void sample_append(nrf_cli_t const * p_cli, int32_t temperature)
+{
+    if (temp_logger_store(temperature) != FLASH_LOG_SUCCESS)
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Flash corrupted, please erase it first.\r\n");
+    }
+}
+
+static void flashwrite_erase_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+{
+    m_link.state   = RADIO_LINK_IDLE;
+    m_resume_valid = false;
+    checkpoint_clear(CHECKPOINT_KEY_RADIO);
+    temp_logger_discard();
+    flash_log_erase();
+    trip_summary_reset();
+}
+
+// Parses and validates "dd/mm/yyyy HH:MM:SS".
+static bool datetime_scan(char const * p_string, civil_time_t * p_time)
+{
+    unsigned int day, month, year, hour, minute, second;
+
+    if (sscanf(p_string, "%2u/%2u/%4u %2u:%2u:%2u", &day, &month, &year, &hour, &minute, &second) != 6)
+    {
+        return false;
+    }
+
+    p_time->year   = (uint16_t)year;
+    p_time->month  = (uint8_t)month;
+    p_time->day    = (uint8_t)day;
+    p_time->hour   = (uint8_t)hour;
+    p_time->minute = (uint8_t)minute;
+    p_time->second = (uint8_t)second;
+    return civil_time_valid(p_time);
+}
+
+// Parses "dd/mm/yyyy HH:MM:SS" into a timestamp comparable with the logged ones.
+static bool datetime_parse(char const * p_string, uint32_t * p_timestamp)
+{
+    civil_time_t time;
+
+    if (!datetime_scan(p_string, &time))
+    {
+        return false;
+    }
+
+    *p_timestamp = civil_time_to_epoch(&time);
+    return true;
+}
+
+static void flashwrite_read_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+{
+    flash_log_cursor_t         cursor;
+    flash_log_sample_t const * p_sample;
+    flash_log_ret_t            ret;
+    uint32_t                   from = 0;
+    uint32_t                   to   = UINT32_MAX;
+
+    if ((argc != 1) && (argc != 3))
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s:%s", argv[0], " bad parameter count - please use quotes\r\n");
+        return;
+    }
+    if ((argc == 3) && (!datetime_parse(argv[1], &from) || !datetime_parse(argv[2], &to)))
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s: bad datetime, expected dd/mm/yyyy HH:MM:SS\r\n", argv[0]);
+        return;
+    }
+
+    if (temp_logger_flush() != FLASH_LOG_SUCCESS)
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Flash corrupted, please erase it first.\r\n");
+    }
+
+    if (flash_log_count() == 0)
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_WARNING, "Please write something first.\r\n");
+        return;
+    }
+
+    flash_log_cursor_seek(&cursor, from);
+    while (((ret = flash_log_cursor_next(&cursor, &p_sample)) == FLASH_LOG_SUCCESS) &&
+           (p_sample->timestamp <= to))
+    {
+        sample_print(p_cli, p_sample, flash_log_cursor_time_uncertain(&cursor));
+    }
+
+    if ((ret != FLASH_LOG_SUCCESS) && (ret != FLASH_LOG_ERROR_NOT_FOUND))
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_WARNING, "Corrupted data found.\r\n");
+    }
+}
+
+// Pushes raw bytes through the CLI transport, sleeping while its TX buffer is full.
+static void dump_write(uint8_t const * p_data, size_t length, void * p_context)
+{
+    nrf_cli_t const * p_cli = (nrf_cli_t const *)p_context;
+    size_t cnt;
+
+    while (length > 0)
+    {
+        ret_code_t err_code = p_cli->p_iface->p_api->write(p_cli->p_iface, p_data, length, &cnt);
+        APP_ERROR_CHECK(err_code);
+
+        if (cnt == 0)
+        {
+            __WFE();
+        }
+        p_data += cnt;
+        length -= cnt;
     }
 }
 
-static void flash_string_write(uint32_t address, const char * src, uint32_t num_words)
+static void flashwrite_dump_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+{
+    if (temp_logger_flush() != FLASH_LOG_SUCCESS)
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Flash corrupted, please erase it first.\r\n");
+        return;
+    }
+
+    (void)log_dump_region((uint32_t const *)FLASH_LOG_START_ADDR,
+                          FLASH_LOG_PAGE_COUNT,
+                          dump_write,
+                          (void *)p_cli);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "\r\n");
+}
+
+static void flashwrite_wear_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
 {
     uint32_t i;
-    // Enable write.
-    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Wen;
-    while (NRF_NVMC->READY == NVMC_READY_READY_Busy)
+
+    for (i = 0; i < FLASH_LOG_PAGE_COUNT; i++)
     {
+        nrf_cli_fprintf(p_cli,
+                        NRF_CLI_NORMAL,
+                        "page %2u: %u erases\r\n",
+                        i,
+                        flash_log_erase_count_get(i));
     }
+}
+
+static void flashwrite_write_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+{
+    char * p_end;
+    long temperature;
 
-    for (i = 0; i < num_words; i++)
+    if (argc != 2)
     {
-        /* Only full 32-bit words can be written to Flash. */
-        ((uint32_t*)address)[i] = 0x000000FFUL & (uint32_t)((uint8_t)src[i]);
-        while (NRF_NVMC->READY == NVMC_READY_READY_Busy)
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s:%s", argv[0], " bad parameter count\r\n");
+        return;
+    }
+
+    temperature = strtol(argv[1], &p_end, 10);
+    if ((p_end == argv[1]) || (*p_end != '\0') ||
+        (temperature < (INT16_MIN / 4)) || (temperature > (INT16_MAX / 4)))
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s: bad temperature: %s\r\n", argv[0], argv[1]);
+        return;
+    }
+
+    sample_append(p_cli, (int32_t)temperature * 4);
+}
+
+static void flashwrite_interval_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+{
+    char * p_end;
+    unsigned long interval;
+
+    if (argc == 1)
+    {
+        interval = temp_logger_interval_get();
+        if (interval == 0)
+        {
+            nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Periodic logging stopped.\r\n");
+        }
+        else
         {
+            nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Logging every %lu s.\r\n", interval);
         }
+        return;
+    }
+    if (argc > 2)
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s:%s", argv[0], " bad parameter count\r\n");
+        return;
+    }
+
+    interval = strtoul(argv[1], &p_end, 10);
+    if ((p_end == argv[1]) || (*p_end != '\0') || (interval > 86400))
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s: bad interval: %s\r\n", argv[0], argv[1]);
+        return;
     }
 
-    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren;
-    while (NRF_NVMC->READY == NVMC_READY_READY_Busy)
+    if (interval == 0)
+    {
+        temp_logger_stop();
+    }
+    else
     {
+        temp_logger_start(interval);
     }
 }
 
+static void power_print_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+{
+    uint64_t awake_ticks = m_total_ticks - m_idle_ticks;
+    uint32_t permille = (m_total_ticks == 0) ? 0 : (uint32_t)((awake_ticks * 1000) / m_total_ticks);
+
+    nrf_cli_fprintf(p_cli,
+                    NRF_CLI_NORMAL,
+                    "Awake %u.%u%% of %u s since the last report.\r\n",
+                    permille / 10,
+                    permille % 10,
+                    (uint32_t)(m_total_ticks / APP_TIMER_TICKS(1000)));
+
+    m_idle_ticks  = 0;
+    m_total_ticks = 0;
+}
 
-static void flashwrite_erase_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+static void limits_print(nrf_cli_t const * p_cli, excursion_summary_t const * p_summary)
 {
-    nrf_nvmc_page_erase(m_data.addr);
+    char lower[16];
+    char upper[16];
 
-    m_data.m_p_flash_data = (flashwrite_example_flash_data_t *)m_data.addr;
+    temperature_format(lower, sizeof(lower), p_summary->lower);
+    temperature_format(upper, sizeof(upper), p_summary->upper);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Limits: %s to %s °C\r\n", lower, upper);
 }
 
-static void flashwrite_read_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+static void flashwrite_profile_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
 {
-    flashwrite_example_flash_data_t * p_data = (flashwrite_example_flash_data_t *)m_data.addr;
-    char string_buff[FLASHWRITE_EXAMPLE_MAX_STRING_LEN + 1]; // + 1 for end of string
+    excursion_profile_t const * p_profile;
+    char * p_end;
+    long   lower;
+    long   upper;
 
-    if ((p_data == m_data.m_p_flash_data) &&
-        (p_data->magic_number != FLASHWRITE_EXAMPLE_BLOCK_VALID))
+    if (argc == 1)
     {
-        nrf_cli_fprintf(p_cli, NRF_CLI_WARNING, "Please write something first.\r\n");
+        limits_print(p_cli, trip_summary_excursion_get());
+        for (p_profile = g_excursion_profiles; p_profile->p_name != NULL; p_profile++)
+        {
+            nrf_cli_fprintf(p_cli,
+                            NRF_CLI_NORMAL,
+                            "  %-8s %d to %d °C\r\n",
+                            p_profile->p_name,
+                            p_profile->lower / 4,
+                            p_profile->upper / 4);
+        }
         return;
     }
 
-    while (p_data <= m_data.m_p_flash_data)
+    if (argc == 2)
     {
-        if ((p_data->magic_number != FLASHWRITE_EXAMPLE_BLOCK_VALID) &&
-            (p_data->magic_number != FLASHWRITE_EXAMPLE_BLOCK_INVALID))
+        for (p_profile = g_excursion_profiles; p_profile->p_name != NULL; p_profile++)
         {
-            nrf_cli_fprintf(p_cli, NRF_CLI_WARNING, "Corrupted data found.\r\n");
+            if (strcmp(p_profile->p_name, argv[1]) == 0)
+            {
+                break;
+            }
+        }
+        if (p_profile->p_name == NULL)
+        {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s: unknown profile: %s\r\n", argv[0], argv[1]);
             return;
         }
-        uint8_t i;
-        for (i = 0 ; i <= FLASHWRITE_EXAMPLE_MAX_STRING_LEN; i++)
+        lower = p_profile->lower / 4;
+        upper = p_profile->upper / 4;
+    }
+    else if (argc == 3)
+    {
+        lower = strtol(argv[1], &p_end, 10);
+        if ((p_end == argv[1]) || (*p_end != '\0'))
+        {
+            lower = LONG_MAX;
+        }
+        upper = strtol(argv[2], &p_end, 10);
+        if ((p_end == argv[2]) || (*p_end != '\0') ||
+            (lower > upper) || (lower < (INT16_MIN / 4)) || (upper > (INT16_MAX / 4)))
         {
-            string_buff[i] = (char)p_data->buffer[i];
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s: bad limits: %s %s\r\n", argv[0], argv[1], argv[2]);
+            return;
         }
-        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "%s\r\n", string_buff);
-        ++p_data;
     }
+    else
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s:%s", argv[0], " bad parameter count\r\n");
+        return;
+    }
+
+    // The whole log is re-evaluated, so staged samples must be in it.
+    if (temp_logger_flush() != FLASH_LOG_SUCCESS)
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Flash corrupted, please erase it first.\r\n");
+    }
+    trip_summary_limits_set((int16_t)(lower * 4), (int16_t)(upper * 4));
+    limits_print(p_cli, trip_summary_excursion_get());
 }
 
-static void flashwrite_write_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+static void flashwrite_verdict_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
 {
-    static uint16_t const page_size = 4096;
+    excursion_summary_t const * p_summary = trip_summary_excursion_get();
+    char string[CIVIL_TIME_STRING_SIZE];
 
-    if (argc < 2)
+    limits_print(p_cli, p_summary);
+    if (p_summary->samples == 0)
     {
-        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s:%s", argv[0], " bad parameter count\r\n");
+        nrf_cli_fprintf(p_cli, NRF_CLI_WARNING, "No samples yet.\r\n");
         return;
     }
-    if (argc > 2)
+
+    if (excursion_passed(p_summary))
     {
-        nrf_cli_fprintf(p_cli,
-                        NRF_CLI_WARNING,
-                        "%s:%s",
-                        argv[0],
-                        " bad parameter count - please use quotes\r\n");
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "PASSED: %u samples within limits.\r\n", p_summary->samples);
         return;
     }
 
-    uint32_t len = strlen(argv[1]);
-    if (len > FLASHWRITE_EXAMPLE_MAX_STRING_LEN)
+    nrf_cli_fprintf(p_cli,
+                    NRF_CLI_WARNING,
+                    "FAILED: %u excursions in %u samples.\r\n",
+                    p_summary->count,
+                    p_summary->samples);
+    nrf_cli_fprintf(p_cli,
+                    NRF_CLI_NORMAL,
+                    "Above: %u min, up to %u.%02u °C over the limit.\r\n",
+                    p_summary->time_above / 60,
+                    p_summary->max_above / 4,
+                    (p_summary->max_above % 4) * 25);
+    nrf_cli_fprintf(p_cli,
+                    NRF_CLI_NORMAL,
+                    "Below: %u min, up to %u.%02u °C under the limit.\r\n",
+                    p_summary->time_below / 60,
+                    p_summary->max_below / 4,
+                    (p_summary->max_below % 4) * 25);
+
+    civil_time_format(p_summary->first_start, string);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "First excursion: %s\r\n", string);
+    civil_time_format(p_summary->last_start, string);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Last excursion:  %s", string);
+    if (p_summary->last_end == 0)
     {
-        nrf_cli_fprintf(p_cli,
-                        NRF_CLI_ERROR,
-                        "Too long string. Please limit entered string to %d chars.\r\n",
-                        FLASHWRITE_EXAMPLE_MAX_STRING_LEN);
-        return;
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, " - ongoing\r\n");
     }
+    else
+    {
+        civil_time_format(p_summary->last_end, string);
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, " to %s\r\n", string);
+    }
+}
 
-    if ((m_data.m_p_flash_data->magic_number != FLASHWRITE_EXAMPLE_BLOCK_NOT_INIT) &&
-        (m_data.m_p_flash_data->magic_number != FLASHWRITE_EXAMPLE_BLOCK_VALID))
+// Formats a value in °C with two decimals.
+static void degrees_format(char * p_buf, size_t size, double degrees)
+{
+    int32_t  centi     = (int32_t)((degrees < 0) ? (degrees * 100 - 0.5) : (degrees * 100 + 0.5));
+    uint32_t abs_centi = (centi < 0) ? -centi : centi;
+
+    snprintf(p_buf, size, "%s%u.%02u", (centi < 0) ? "-" : "", abs_centi / 100, abs_centi % 100);
+}
+
+static void flashwrite_stats_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+{
+    stats_t const * p_stats = trip_summary_stats_get();
+    char min[16];
+    char max[16];
+    char mean[16];
+    char stddev[16];
+    char mkt[16];
+
+    if (p_stats->count == 0)
     {
-        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Flash corrupted, please errase it first.");
+        nrf_cli_fprintf(p_cli, NRF_CLI_WARNING, "No samples yet.\r\n");
         return;
     }
 
-    if (m_data.m_p_flash_data->magic_number == FLASHWRITE_EXAMPLE_BLOCK_VALID)
+    temperature_format(min, sizeof(min), p_stats->min);
+    temperature_format(max, sizeof(max), p_stats->max);
+    degrees_format(mean, sizeof(mean), stats_mean(p_stats));
+    degrees_format(stddev, sizeof(stddev), stats_stddev(p_stats));
+    degrees_format(mkt, sizeof(mkt), stats_mkt(p_stats));
+
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Samples: %u\r\n", p_stats->count);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Min:     %s °C\r\n", min);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Max:     %s °C\r\n", max);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Mean:    %s °C (std dev %s)\r\n", mean, stddev);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "MKT:     %s °C\r\n", mkt);
+}
+
+static void flashwrite_batch_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+{
+    char * p_end;
+    unsigned long batch;
+
+    if (argc == 1)
     {
-        uint32_t new_end_addr = (uint32_t)(m_data.m_p_flash_data + 2);
-        uint32_t diff = new_end_addr - m_data.addr;
-        if (diff > page_size)
+        if (temp_logger_low_battery())
+        {
+            nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Low battery: committing every sample.\r\n");
+        }
+        else
+        {
+            nrf_cli_fprintf(p_cli,
+                            NRF_CLI_NORMAL,
+                            "Committing every %u samples.\r\n",
+                            temp_logger_batch_get());
+        }
+        if (temp_logger_lost_get() > 0)
         {
             nrf_cli_fprintf(p_cli,
                             NRF_CLI_WARNING,
-                            "Not enough space - please erase flash first.\r\n");
-            return;
+                            "%u samples lost to failed commits.\r\n",
+                            temp_logger_lost_get());
         }
-        nrf_nvmc_write_word((uint32_t)&m_data.m_p_flash_data->magic_number,
-                            FLASHWRITE_EXAMPLE_BLOCK_INVALID);
-        ++m_data.m_p_flash_data;
+        return;
+    }
+    if (argc > 2)
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s:%s", argv[0], " bad parameter count\r\n");
+        return;
     }
 
-    //++len -> store also end of string '\0'
-    flash_string_write((uint32_t)m_data.m_p_flash_data->buffer, argv[1], ++len);
-    nrf_nvmc_write_word((uint32_t)&m_data.m_p_flash_data->magic_number,
-                        FLASHWRITE_EXAMPLE_BLOCK_VALID);
+    batch = strtoul(argv[1], &p_end, 10);
+    if ((p_end == argv[1]) || (*p_end != '\0') || (batch == 0) || (batch > TEMP_LOGGER_MAX_BATCH))
+    {
+        nrf_cli_fprintf(p_cli,
+                        NRF_CLI_ERROR,
+                        "%s: batch must be between 1 and %d\r\n",
+                        argv[0],
+                        TEMP_LOGGER_MAX_BATCH);
+        return;
+    }
+
+    if (temp_logger_batch_set(batch) != FLASH_LOG_SUCCESS)
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Flash corrupted, please erase it first.\r\n");
+    }
 }
 
 static void flashwrite_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
@@ -310,30 +776,33 @@ static void flashwrite_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
 
 static void temp_print_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
 {
-    uint32_t temp;
+    int32_t temp = temp_sensor_sample_wait();
+    char    time_string[CIVIL_TIME_STRING_SIZE];
+    char    temperature_string[16];
 
-    nrf_temp_init();
-    //Start temperature measurement
-    NRF_TEMP->TASKS_START = 1;
-    while(NRF_TEMP->EVENTS_DATARDY == 0) {
-      //Temperature measurement complete, data ready
-    }
-    NRF_TEMP->EVENTS_DATARDY = 0;
-    temp = nrf_temp_read()/4;
-    //Stop temperature measurement
-    NRF_TEMP->TASKS_STOP = 1;
-    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "%s %d °C\r\n", nrf_cal_get_time_string(true), temp);
+    civil_time_format(nrf_cal_get_epoch(true), time_string);
+    temperature_format(temperature_string, sizeof(temperature_string), temp);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "%s %s °C\r\n", time_string, temperature_string);
 
+    sample_append(p_cli, temp);
 }
 
 static void datetime_print_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
 {
-    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "%s\r\n", nrf_cal_get_time_string(true));
+    char time_string[CIVIL_TIME_STRING_SIZE];
+
+    civil_time_format(nrf_cal_get_epoch(true), time_string);
+    nrf_cli_fprintf(p_cli,
+                    NRF_CLI_NORMAL,
+                    "%s%s\r\n",
+                    time_string,
+                    nrf_cal_time_uncertain() ? " (uncertain, please set the time)" : "");
 }
 
 static void datetime_set_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
 {
-    uint32_t year, month, day, hour, minute, second;
+    civil_time_t time;
+
     if (argc < 2)
     {
         nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s:%s", argv[0], " bad parameter count\r\n");
@@ -348,60 +817,291 @@ static void datetime_set_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
                         " bad parameter count - please use quotes\r\n");
         return;
     }
-    nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s\n", argv[1], " input\r\n");
-    char *dateString = argv[1];
-    if (sscanf(dateString, "%2d/%2d/%4d %2d:%2d:%2d", &day, &month, &year,  &hour, &minute, &second) == 6) {
-    //TODO Validate datetime
-    //TODO Bug with month, because range  (0, 11)
+    if (!datetime_scan(argv[1], &time))
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s: bad datetime %s\r\n", argv[0], argv[1]);
+        return;
     }
 
-   nrf_cli_fprintf(p_cli, NRF_CLI_INFO,"year: %d; month: %d; day: %d;\n",
-            year, month, day);
+    nrf_cli_fprintf(p_cli, NRF_CLI_INFO,"year: %d; month: %d; day: %d;\n",
+            time.year, time.month, time.day);
     nrf_cli_fprintf(p_cli, NRF_CLI_INFO,"hour: %d; minute: %d; second: %d\n",
-            hour, minute, second);
-    nrf_cal_set_time(year, month, day, hour, minute, second);
+            time.hour, time.minute, time.second);
+    nrf_cal_set_time(time.year, time.month, time.day, time.hour, time.minute, time.second);
+    calendar_backup_update();
 }
 
-static void send_packet_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+static void flashwrite_send_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
 {
-    if (argc < 2)
+    flash_log_cursor_t         cursor;
+    flash_log_sample_t const * p_sample;
+    char                       time_string[CIVIL_TIME_STRING_SIZE];
+    char                     * p_end;
+    unsigned long              value;
+    uint32_t                   count = RADIO_FRAME_MAX_SAMPLES;
+    uint32_t                   skip  = 0;
+    uint32_t                   reply_us;
+    bool                       resume;
+
+    if (argc > 2)
     {
         nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s:%s", argv[0], " bad parameter count\r\n");
         return;
     }
+    resume = (argc == 2) && (strcmp(argv[1], "resume") == 0);
+    if ((argc == 2) && !resume)
+    {
+        // Counts beyond the samples in the log send them all.
+        value = strtoul(argv[1], &p_end, 10);
+        if ((p_end == argv[1]) || (*p_end != '\0') || (value == 0) || (value > SEND_COUNT_MAX))
+        {
+            nrf_cli_fprintf(p_cli,
+                            NRF_CLI_ERROR,
+                            "%s: count must be between 1 and %u, or \"resume\"\r\n",
+                            argv[0],
+                            SEND_COUNT_MAX);
+            return;
+        }
+        count = (uint32_t)value;
+    }
+    if (radio_busy())
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_WARNING, "Radio busy sending or in gateway mode.\r\n");
+        return;
+    }
+
+    if (temp_logger_flush() != FLASH_LOG_SUCCESS)
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "Flash corrupted, please erase it first.\r\n");
+    }
+
+    if (resume)
+    {
+        // Everything after the newest sample a receiver has acknowledged, found by its
+        // place in the log: timestamps run backwards where the clock was set back.
+        count = flash_log_count();
+        if (m_resume_valid && flash_log_cursor_seek_position(&cursor, &m_resume.position))
+        {
+            civil_time_format(m_resume.timestamp, time_string);
+            nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Sending the samples after %s.\r\n", time_string);
+        }
+        else if (m_resume_valid)
+        {
+            nrf_cli_fprintf(p_cli,
+                            NRF_CLI_WARNING,
+                            "The last acknowledged sample is no longer in the log, sending all %u samples.\r\n",
+                            count);
+        }
+        else
+        {
+            flash_log_cursor_begin(&cursor);
+            nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Nothing acknowledged yet, sending all %u samples.\r\n", count);
+        }
+    }
+    else
+    {
+        if (flash_log_count() > count)
+        {
+            skip = flash_log_count() - count;
+        }
+        flash_log_cursor_begin(&cursor);
+        while ((skip > 0) && (flash_log_cursor_next(&cursor, &p_sample) == FLASH_LOG_SUCCESS))
+        {
+            skip--;
+        }
+        count = (flash_log_count() > count) ? count : flash_log_count();
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Sending %u samples.\r\n", count);
+    }
+
+    // The reply window covers the receiver turning around and its ACK on air, rounded up
+    // to whole ticks plus one for the phase of the tick clock.
+    reply_us = RADIO_LINK_TURNAROUND_US + radio_config_air_time(radio_config_profile_get(), RADIO_FRAME_HEADER_SIZE);
+    m_reply_timeout = (uint32_t)(((uint64_t)reply_us * NRF_CAL_TICKS_PER_SECOND + 999999) / 1000000) + 1;
+
+    // The rest is sent from the scheduler as ACKs arrive.
+    radio_link_start(&m_link, &cursor, count);
+    send_next();
+}
+
+// Streams the received frames to the CLI UART.
+static void gateway_drain_evt(void * p_event_data, uint16_t event_size)
+{
+    m_gateway_scheduled = false;
+
+    while (m_gateway_head != m_gateway_tail)
+    {
+        uint8_t const * p_slot = m_gateway_fifo[m_gateway_head % GATEWAY_FIFO_SIZE];
+
+        (void)log_dump_packet(&p_slot[1], p_slot[0], dump_write, (void *)mp_gateway_cli);
+        m_gateway_head++;
+    }
+}
+
+// Acknowledges every sample frame and keeps the new ones for the UART. A frame that finds
+// the FIFO full is neither recorded nor acknowledged, so the logger sends it again.
+static uint32_t gateway_receive_handler(uint8_t const * p_packet, uint32_t size, uint8_t * p_reply)
+{
+    radio_frame_header_t header;
+    gateway_frame_t      verdict;
+    uint8_t            * p_slot;
+
+    if ((p_reply == NULL) || (m_gateway_tail - m_gateway_head >= GATEWAY_FIFO_SIZE))
+    {
+        m_gateway_overflows++;
+        return 0;
+    }
+
+    verdict = gateway_packet_put(&m_gateway, p_packet, size, &header);
+    if (verdict == GATEWAY_FRAME_INVALID)
+    {
+        return 0;
+    }
+    if (verdict == GATEWAY_FRAME_NEW)
+    {
+        p_slot    = m_gateway_fifo[m_gateway_tail % GATEWAY_FIFO_SIZE];
+        p_slot[0] = (uint8_t)size;
+        memcpy(&p_slot[1], p_packet, size);
+        m_gateway_tail++;
+        if (!m_gateway_scheduled)
+        {
+            m_gateway_scheduled = true;
+            APP_ERROR_CHECK(app_sched_event_put(NULL, 0, gateway_drain_evt));
+        }
+    }
+
+    return radio_frame_ack_encode(p_reply, &header);
+}
+
+static void flashwrite_gateway_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+{
     if (argc > 2)
     {
-        nrf_cli_fprintf(p_cli,
-                        NRF_CLI_WARNING,
-                        "%s:%s",
-                        argv[0],
-                        " bad parameter count - please use quotes\r\n");
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s:%s", argv[0], " bad parameter count\r\n");
+        return;
+    }
+
+    if ((argc == 2) && (strcmp(argv[1], "on") == 0))
+    {
+        if (!m_gateway_on && radio_busy())
+        {
+            nrf_cli_fprintf(p_cli, NRF_CLI_WARNING, "Still sending, please wait.\r\n");
+            return;
+        }
+        mp_gateway_cli = p_cli;
+        m_gateway_on   = true;
+        radio_tx_receive_set(gateway_receive_handler);
+        nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Gateway on, read this port with tools/gateway.\r\n");
+        return;
+    }
+    if ((argc == 2) && (strcmp(argv[1], "off") == 0))
+    {
+        radio_tx_receive_set(NULL);
+        m_gateway_on = false;
+    }
+    else if (argc == 2)
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s: unknown parameter: %s\r\n", argv[0], argv[1]);
+        return;
+    }
+
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Gateway %s: %u devices, %u frames, %u duplicates, %u invalid\r\n",
+                    m_gateway_on ? "on" : "off",
+                    m_gateway.device_count,
+                    m_gateway.frames,
+                    m_gateway.duplicates,
+                    m_gateway.invalid);
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "  %u samples, %u repeated, %u frames refused for lack of room\r\n",
+                    m_gateway.samples,
+                    m_gateway.repeated,
+                    m_gateway_overflows);
+}
+
+static void flashwrite_phy_cmd(nrf_cli_t const * p_cli, size_t argc, char **argv)
+{
+    radio_config_profile_t profile;
+    uint32_t               air_time;
+
+    if (argc > 2)
+    {
+        nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s:%s", argv[0], " bad parameter count\r\n");
         return;
     }
-    packet = atoi(argv[1]);
-    if (packet != 0)
+
+    if (argc == 2)
     {
-      
-      send_packet();
-      nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "The contents of the package was %u\n", (unsigned int)packet);
-      packet = 0;
+        for (profile = 0; profile < RADIO_CONFIG_PROFILE_COUNT; profile++)
+        {
+            if (strcmp(radio_config_profile_name(profile), argv[1]) == 0)
+            {
+                break;
+            }
+        }
+        if (profile == RADIO_CONFIG_PROFILE_COUNT)
+        {
+            nrf_cli_fprintf(p_cli, NRF_CLI_ERROR, "%s: unknown profile: %s\r\n", argv[0], argv[1]);
+            return;
+        }
+        // The radio may only be reconfigured while it is disabled.
+        if (radio_busy())
+        {
+            nrf_cli_fprintf(p_cli, NRF_CLI_WARNING, "Radio busy sending or in gateway mode.\r\n");
+            return;
+        }
+        radio_config_profile_set(profile);
+    }
+
+    // Air time of a full frame, the figure to plan battery life and duty cycle limits with.
+    nrf_cli_fprintf(p_cli, NRF_CLI_NORMAL, "Radio profile: %s\r\n",
+                    radio_config_profile_name(radio_config_profile_get()));
+    for (profile = 0; profile < RADIO_CONFIG_PROFILE_COUNT; profile++)
+    {
+        air_time = radio_config_air_time(profile, RADIO_FRAME_MAX_SIZE);
+        nrf_cli_fprintf(p_cli,
+                        NRF_CLI_NORMAL,
+                        "  %-6s %5u us per frame of %u samples, %3u us per sample\r\n",
+                        radio_config_profile_name(profile),
+                        air_time,
+                        RADIO_FRAME_MAX_SAMPLES,
+                        air_time / RADIO_FRAME_MAX_SAMPLES);
     }
 }
 
  NRF_CLI_CREATE_STATIC_SUBCMD_SET(m_sub_flash)
 {
     NRF_CLI_CMD(erase, NULL, "Erase flash.",          flashwrite_erase_cmd),
-    NRF_CLI_CMD(read,  NULL, "Read data from flash.", flashwrite_read_cmd),
-    NRF_CLI_CMD(write, NULL, "Write data to flash.\n"
-                             "Limitations:\n"
-                             "- maximum 16 entries,\n"
-                             "- each entry is maximum 62 chars long.",
+    NRF_CLI_CMD(read,  NULL, "Read data from flash, optionally only a time window.\n"
+                             "Example: flash read \"21/12/2021 02:00:00\" \"21/12/2021 04:00:00\"",
+                                                      flashwrite_read_cmd),
+    NRF_CLI_CMD(dump,  NULL, "Stream the raw log as binary frames for tools/log2csv.", flashwrite_dump_cmd),
+    NRF_CLI_CMD(wear,  NULL, "Print erase count of every log page.", flashwrite_wear_cmd),
+    NRF_CLI_CMD(write, NULL, "Write temperature (°C) to flash.\n"
+                             "Example: flash write -18",
                                                       flashwrite_write_cmd),
-    NRF_CLI_CMD(temp, NULL, "Print current temperatute.", temp_print_cmd),
+    NRF_CLI_CMD(batch, NULL, "Print or set how many samples are staged in RAM before a flash commit.\n"
+                             "Example: flash batch 16",
+                                                      flashwrite_batch_cmd),
+    NRF_CLI_CMD(interval, NULL, "Print or set the periodic logging interval in seconds.\n"
+                                "Example: flash interval 60 (0 stops logging)",
+                                                      flashwrite_interval_cmd),
+    NRF_CLI_CMD(profile, NULL, "Print or set the temperature limits, by profile name or in °C.\n"
+                               "Example: flash profile chilled, flash profile 2 8",
+                                                      flashwrite_profile_cmd),
+    NRF_CLI_CMD(verdict, NULL, "Print the excursion summary of the trip.", flashwrite_verdict_cmd),
+    NRF_CLI_CMD(stats, NULL, "Print min, max, mean and Mean Kinetic Temperature of the trip.",
+                                                      flashwrite_stats_cmd),
+    NRF_CLI_CMD(power, NULL, "Print CPU duty cycle since the last report.", power_print_cmd),
+    NRF_CLI_CMD(temp, NULL, "Print current temperatute and write it to flash.", temp_print_cmd),
     NRF_CLI_CMD(datetime, NULL, "Print current datetime", datetime_print_cmd),
     NRF_CLI_CMD(setdatetime, NULL, "Set current datetime.\n"
                                     "Example 21/12/2021 12:12:00", datetime_set_cmd),
-    NRF_CLI_CMD(send-packet, NULL, "Print current temperatute.", send_packet_cmd),
+    NRF_CLI_CMD(send, NULL, "Send the newest samples over the radio, up to 59 per frame, each\n"
+                            "acknowledged by the receiver. \"resume\" sends everything after\n"
+                            "the newest sample acknowledged so far.\n"
+                            "Example: flash send 120",         flashwrite_send_cmd),
+    NRF_CLI_CMD(phy, NULL, "Print the radio profiles with their air time, or select one.\n"
+                           "Example: flash phy lr125",         flashwrite_phy_cmd),
+    NRF_CLI_CMD(gateway, NULL, "Print gateway statistics, or turn the gateway mode on or off.\n"
+                               "Example: flash gateway on",    flashwrite_gateway_cmd),
     NRF_CLI_SUBCMD_SET_END
 };
 NRF_CLI_CMD_REGISTER(flash, &m_sub_flash, "Flash access command.", flashwrite_cmd);
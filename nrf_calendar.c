@@ -11,103 +11,263 @@
  */
  
 #include "nrf_calendar.h"
+#include "civil_time.h"
 #include "nrf.h"
  
-static struct tm time_struct, m_tm_return_time; 
-static time_t m_time, m_last_calibrate_time = 0;
-static float m_calibrate_factor = 0.0f;
-static uint32_t m_rtc_increment = 60;
-static void (*cal_event_callback)(void) = 0;
+#define CAL_DRIFT_ONE           4294967296LL    // Drift correction of 100 %, see m_drift_q32.
+#define CAL_COUNTER_MASK        0x00FFFFFF      // The RTC counter is 24 bits wide.
+#define CAL_COMPARE_RANGE       0x00800000      // Furthest compare target that cannot be mistaken for a past one.
+#define CAL_COMPARE_MIN_AHEAD   2               // A compare closer than this to the counter may not trigger.
+#define CAL_RETAINED_MAGIC      0x43414C52      // "CALR"
+
+// Placed where the startup code neither copies nor zeroes, so it survives any reset that
+// keeps RAM powered (pin, watchdog, soft reset, lockup). Power-on and brown-out lose it.
+#if defined(__SES_ARM)
+#define CAL_NOINIT              __attribute__((section(".non_init")))
+#elif defined(__ICCARM__)
+#define CAL_NOINIT              __no_init
+#elif defined(__ARMCC_VERSION)
+#define CAL_NOINIT              __attribute__((section(".bss.noinit"), zero_init))
+#else
+#define CAL_NOINIT              __attribute__((section(".noinit")))
+#endif
+
+typedef struct
+{
+    uint32_t magic;
+    nrf_cal_state_t state;
+    uint32_t check;                     // Complement of the sum of the words above.
+} cal_retained_t;
+
+static uint32_t m_time = 0;             // Time at m_calibrate_ticks.
+static uint32_t m_last_calibrate_time = 0;  // Time of the last set, 0 if there is no reference for calibration.
+static uint64_t m_calibrate_ticks = 0;  // Tick at which the time was last set or restored.
+static bool m_uncertain = true;
+static bool m_retained_valid = false;   // The calendar came through the reset in retained RAM.
+static CAL_NOINIT cal_retained_t m_retained;
+static int32_t m_drift_q32 = 0;         // Rate correction as a fraction of elapsed time, in units of 2^-32 (0.00023 ppm).
+static volatile uint32_t m_overflows = 0;
+
+// One periodic callback per compare channel, each on its own CC register.
+static struct
+{
+    void (*callback)(void);
+    uint64_t period;                    // In ticks, 0 while the channel is off.
+    uint64_t next;                      // Tick of the next callback.
+} m_channels[NRF_CAL_CHANNEL_COUNT];
+
+uint64_t nrf_cal_get_ticks(void)
+{
+    uint32_t overflows, counter;
+    bool pending;
+    do
+    {
+        overflows = m_overflows;
+        counter = CAL_RTC->COUNTER;
+        // The counter may have wrapped while the overflow interrupt is still pending.
+        pending = CAL_RTC->EVENTS_OVRFLW && (counter < CAL_COMPARE_RANGE);
+    } while(overflows != m_overflows);
+    if(pending) overflows++;
+    return ((uint64_t)overflows << 24) | counter;
+}
+
+// Points the channel's CC register at its next callback tick, or as far towards it as the counter allows.
+static void compare_schedule(uint32_t channel)
+{
+    uint64_t now = nrf_cal_get_ticks();
+    uint64_t target = m_channels[channel].next;
+    if(target > now + CAL_COMPARE_RANGE) target = now + CAL_COMPARE_RANGE;
+    if(target < now + CAL_COMPARE_MIN_AHEAD) target = now + CAL_COMPARE_MIN_AHEAD;
+    CAL_RTC->CC[channel] = (uint32_t)target & CAL_COUNTER_MASK;
+}
  
+static uint32_t retained_check(cal_retained_t const * p_retained)
+{
+    uint32_t const * p_word = (uint32_t const *)p_retained;
+    uint32_t sum = 0;
+    for(uint32_t i = 0; i < (sizeof(cal_retained_t) / sizeof(uint32_t)) - 1; i++) sum += p_word[i];
+    return ~sum;
+}
+
+// Refreshes the copy in retained RAM. Cheap enough for every calendar interrupt.
+static void retained_save(void)
+{
+    nrf_cal_state_get(&m_retained.state);
+    m_retained.magic = CAL_RETAINED_MAGIC;
+    m_retained.check = retained_check(&m_retained);
+}
+
+// Continues from the given time at the current tick. The next set starts a new
+// calibration, as the ticks lost over the reset are unknown.
+static void time_restore(uint32_t time)
+{
+    m_time = time;
+    m_calibrate_ticks = nrf_cal_get_ticks();
+    m_last_calibrate_time = 0;
+}
+
 void nrf_cal_init(void)
 {
-    // Select the 32 kHz crystal and start the 32 kHz clock
-    NRF_CLOCK->LFCLKSRC = CLOCK_LFCLKSRC_SRC_Xtal << CLOCK_LFCLKSRC_SRC_Pos;
-    NRF_CLOCK->EVENTS_LFCLKSTARTED = 0;
-    NRF_CLOCK->TASKS_LFCLKSTART = 1;
-    while(NRF_CLOCK->EVENTS_LFCLKSTARTED == 0);
+    // Pick up the time from retained RAM before any interrupt can overwrite it.
+    m_retained_valid = (m_retained.magic == CAL_RETAINED_MAGIC) && (m_retained.check == retained_check(&m_retained));
+    if(m_retained_valid)
+    {
+        // The copy is as old as the last calendar interrupt and the reset stopped the RTC,
+        // so the time continues up to 512 s late until it is set again.
+        m_drift_q32 = m_retained.state.drift_q32;
+        m_uncertain = true;
+    }
+    
+
+    // Select the 32 kHz crystal and start the 32 kHz clock, unless it already runs for
+    // app_timer: restarting it would stall every RTC.
+    if((NRF_CLOCK->LFCLKSTAT & CLOCK_LFCLKSTAT_STATE_Msk) == 0)
+    {
+        NRF_CLOCK->LFCLKSRC = CLOCK_LFCLKSRC_SRC_Xtal << CLOCK_LFCLKSRC_SRC_Pos;
+        NRF_CLOCK->EVENTS_LFCLKSTARTED = 0;
+        NRF_CLOCK->TASKS_LFCLKSTART = 1;
+        while(NRF_CLOCK->EVENTS_LFCLKSTARTED == 0);
+    }
     
-    // Configure the RTC for 1 minute wakeup (default)
-    CAL_RTC->PRESCALER = 0xFFF;
-    CAL_RTC->EVTENSET = RTC_EVTENSET_COMPARE0_Msk;
-    CAL_RTC->INTENSET = RTC_INTENSET_COMPARE0_Msk;
-    CAL_RTC->CC[0] = m_rtc_increment * 8;
+    // Run the RTC free at the full 32768 Hz and extend it to 64 bits on overflow.
+    // The compare channels are enabled as callbacks are set.
+    CAL_RTC->PRESCALER = 0;
+    CAL_RTC->EVTENSET = RTC_EVTENSET_OVRFLW_Msk;
+    CAL_RTC->INTENSET = RTC_INTENSET_OVRFLW_Msk;
     CAL_RTC->TASKS_START = 1;
+    if(m_retained_valid) time_restore(m_retained.state.epoch);
     NVIC_SetPriority(CAL_RTC_IRQn, CAL_RTC_IRQ_Priority);
     NVIC_EnableIRQ(CAL_RTC_IRQn);  
 }
 
+static void channel_set(uint32_t channel, void (*callback)(void), uint64_t period)
+{
+    uint32_t mask = RTC_INTENSET_COMPARE0_Msk << channel;
+    if(channel >= NRF_CAL_CHANNEL_COUNT) return;
+    
+    // The channel is off while it changes, so its interrupt never sees half an update.
+    NVIC_DisableIRQ(CAL_RTC_IRQn);
+    CAL_RTC->INTENCLR = mask;
+    CAL_RTC->EVTENCLR = mask;
+    CAL_RTC->EVENTS_COMPARE[channel] = 0;
+    m_channels[channel].callback = callback;
+    m_channels[channel].period = (callback != 0) ? period : 0;
+    if(m_channels[channel].period != 0)
+    {
+        m_channels[channel].next = nrf_cal_get_ticks() + period;
+        compare_schedule(channel);
+        CAL_RTC->EVTENSET = mask;
+        CAL_RTC->INTENSET = mask;
+    }
+    NVIC_EnableIRQ(CAL_RTC_IRQn);
+}
+
+void nrf_cal_set_channel_callback(uint32_t channel, void (*callback)(void), uint32_t period)
+{
+    channel_set(channel, callback, period);
+}
+
 void nrf_cal_set_callback(void (*callback)(void), uint32_t interval)
 {
     // Set the calendar callback, and set the callback interval in seconds
-    cal_event_callback = callback;
-    m_rtc_increment = interval;
-    m_time += CAL_RTC->COUNTER / 8;
-    CAL_RTC->TASKS_CLEAR = 1;
-    CAL_RTC->CC[0] = interval * 8;  
+    channel_set(NRF_CAL_CHANNEL_LOGGER, callback, (uint64_t)interval * NRF_CAL_TICKS_PER_SECOND);
+}
+
+// Returns the uncalibrated number of RTC ticks since the time was last set.
+static int64_t elapsed_ticks_get(void)
+{
+    return (int64_t)(nrf_cal_get_ticks() - m_calibrate_ticks);
 }
  
 void nrf_cal_set_time(uint32_t year, uint32_t month, uint32_t day, uint32_t hour, uint32_t minute, uint32_t second)
 {
-    static time_t uncal_difftime, difftime, newtime;
-    time_struct.tm_year = year - 1900;
-    time_struct.tm_mon = month;
-    time_struct.tm_mday = day;
-    time_struct.tm_hour = hour;
-    time_struct.tm_min = minute;
-    time_struct.tm_sec = second;   
-    newtime = mktime(&time_struct);
-    CAL_RTC->TASKS_CLEAR = 1;  
+    civil_time_t time = { year, month, day, hour, minute, second };
+    uint32_t newtime = civil_time_to_epoch(&time);
+    int64_t uncal_ticks, cal_ticks;     // Ticks counted and ticks missed since the last set.
+    uncal_ticks = elapsed_ticks_get();
     
-    // Calculate the calibration offset 
-    if(m_last_calibrate_time != 0)
+    // Calculate the rate correction in fixed point; this is the only division involved.
+    // Corrections beyond 1000 ppm mean the time was set by hand, not measured drift.
+    if((m_last_calibrate_time != 0) && (uncal_ticks > 0))
     {
-        difftime = newtime - m_last_calibrate_time;
-        uncal_difftime = m_time - m_last_calibrate_time;
-        m_calibrate_factor = (float)difftime / (float)uncal_difftime;
+        cal_ticks = ((int64_t)newtime - m_last_calibrate_time) * NRF_CAL_TICKS_PER_SECOND - uncal_ticks;
+        if((cal_ticks * 1000 <= uncal_ticks) && (cal_ticks * 1000 >= -uncal_ticks))
+        {
+            m_drift_q32 = (int32_t)((cal_ticks * CAL_DRIFT_ONE) / uncal_ticks);
+        }
     }
     
     // Assign the new time to the local time variables
-    m_time = m_last_calibrate_time = newtime;
+    m_time = newtime;
+    m_last_calibrate_time = newtime;
+    m_calibrate_ticks += uncal_ticks;
+    m_uncertain = false;
+    retained_save();
 }    
 
-struct tm *nrf_cal_get_time(void)
+uint32_t nrf_cal_get_epoch(bool calibrated)
 {
-    time_t return_time;
-    return_time = m_time + CAL_RTC->COUNTER / 8;
-    m_tm_return_time = *localtime(&return_time);
-    return &m_tm_return_time;
+    int64_t ticks = elapsed_ticks_get();
+    if(calibrated)
+    {
+        // Integer only: the correction is a 64-bit multiply and shift. Scaling the ticks
+        // down first keeps the product in range for years; it costs at most 2 ms.
+        ticks += ((ticks >> 16) * m_drift_q32) >> 16;
+    }
+    return m_time + (uint32_t)(ticks / NRF_CAL_TICKS_PER_SECOND);
 }
 
-struct tm *nrf_cal_get_time_calibrated(void)
+bool nrf_cal_time_uncertain(void)
 {
-    time_t uncalibrated_time, calibrated_time;
-    if(m_calibrate_factor != 0.0f)
-    {
-        uncalibrated_time = m_time + CAL_RTC->COUNTER / 8;
-        calibrated_time = m_last_calibrate_time + (time_t)((float)(uncalibrated_time - m_last_calibrate_time) * m_calibrate_factor + 0.5f);
-        m_tm_return_time = *localtime(&calibrated_time);
-        return &m_tm_return_time;
-    }
-    else return nrf_cal_get_time();
+    return m_uncertain;
 }
 
-char *nrf_cal_get_time_string(bool calibrated)
+void nrf_cal_state_get(nrf_cal_state_t * p_state)
 {
-    static char cal_string[80];
-    strftime(cal_string, 80, "%d/%m/%Y - %H:%M:%S", (calibrated ? nrf_cal_get_time_calibrated() : nrf_cal_get_time()));
-    return cal_string;
+    p_state->epoch = nrf_cal_get_epoch(true);
+    p_state->drift_q32 = m_drift_q32;
+    p_state->uncertain = m_uncertain;
+}
+
+void nrf_cal_restore(nrf_cal_state_t const * p_state, uint32_t min_epoch)
+{
+    // Without retained RAM the device may have been off for any time, so the saved
+    // time is only a lower bound.
+    if(!m_retained_valid && (p_state != 0))
+    {
+        m_drift_q32 = p_state->drift_q32;
+        time_restore(p_state->epoch);
+        m_uncertain = true;
+    }
+    if((int32_t)(nrf_cal_get_epoch(true) - min_epoch) < 0) time_restore(min_epoch);
+    retained_save();
 }
  
 void CAL_RTC_IRQHandler(void)
 {
-    if(CAL_RTC->EVENTS_COMPARE[0])
+    if(CAL_RTC->EVENTS_OVRFLW)
+    {
+        CAL_RTC->EVENTS_OVRFLW = 0;
+        m_overflows++;
+        retained_save();
+    }
+
+    for(uint32_t channel = 0; channel < NRF_CAL_CHANNEL_COUNT; channel++)
     {
-        CAL_RTC->EVENTS_COMPARE[0] = 0;
-        
-        CAL_RTC->TASKS_CLEAR = 1;
-        
-        m_time += m_rtc_increment;
-        if(cal_event_callback) cal_event_callback();
+        if(CAL_RTC->EVENTS_COMPARE[channel])
+        {
+            CAL_RTC->EVENTS_COMPARE[channel] = 0;
+            if(m_channels[channel].period == 0) continue;
+            
+            // The next callback is due a whole period after the previous one was due, not
+            // after this interrupt ran, so latency never adds up.
+            if(nrf_cal_get_ticks() >= m_channels[channel].next)
+            {
+                m_channels[channel].next += m_channels[channel].period;
+                m_channels[channel].callback();
+            }
+            compare_schedule(channel);
+            retained_save();
+        }
     }
 }
\ No newline at end of file
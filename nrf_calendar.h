@@ -15,7 +15,6 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include "time.h"
 
 // Change the following defines to change the RTC timer used or the interrupt priority
 #define CAL_RTC                 NRF_RTC0
@@ -23,26 +22,66 @@
 #define CAL_RTC_IRQHandler      RTC0_IRQHandler
 #define CAL_RTC_IRQ_Priority    3
 
+// Resolution of the tick clock. The RTC runs free at the LFCLK rate.
+#define NRF_CAL_TICKS_PER_SECOND    32768
+
+// Compare channels, one per independent periodic callback. CAL_RTC needs a CC register for
+// each: RTC0 has three, RTC1 and RTC2 have four.
+#define NRF_CAL_CHANNEL_LOGGER      0
+#define NRF_CAL_CHANNEL_RADIO       1
+#define NRF_CAL_CHANNEL_UI          2
+#define NRF_CAL_CHANNEL_COUNT       3
+
+// Calendar state worth keeping over a reset, see nrf_cal_state_get().
+typedef struct
+{
+    uint32_t epoch;             // Calibrated time when the state was taken.
+    int32_t  drift_q32;         // Rate correction found by the last calibration.
+    uint32_t uncertain;         // Non-zero if the time could not be trusted.
+} nrf_cal_state_t;
+
 // Initializes the calendar library. Run this before calling any other functions. 
+// After a reset that kept RAM powered the calendar continues from a copy kept in retained
+// RAM, which is as old as the last calendar interrupt: the time may run up to 512 s late,
+// so it is marked uncertain.
 void nrf_cal_init(void);
 
 // Enables a callback feature in the calendar library that can call a function automatically at the specified interval (seconds).
+// Uses NRF_CAL_CHANNEL_LOGGER.
 void nrf_cal_set_callback(void (*callback)(void), uint32_t interval);
 
-// Sets the date and time stored in the calendar library. 
+// Calls a function every period ticks (up to 36 hours) on the given channel, from the RTC
+// interrupt. The callbacks stay in step with the tick clock however late the interrupt runs.
+// A NULL callback or a zero period turns the channel off.
+void nrf_cal_set_channel_callback(uint32_t channel, void (*callback)(void), uint32_t period);
+
+// Sets the date and time stored in the calendar library, in UTC with months from 1 to 12. 
 // When this function is called a second time calibration data will be automatically generated based on the error in time since the
 // last call to the set time function. To ensure good calibration this function should not be called too often 
 // (depending on the accuracy of the 32 kHz clock it should be sufficient to call it between once a week and once a month). 
 void nrf_cal_set_time(uint32_t year, uint32_t month, uint32_t day, uint32_t hour, uint32_t minute, uint32_t second);
 
-// Returns the uncalibrated time as a tm struct. For more information about the tm struct and the time.h library in general please refer to:
-// http://www.tutorialspoint.com/c_standard_library/time_h.htm
-struct tm *nrf_cal_get_time(void);
+// Returns the number of RTC ticks since nrf_cal_init(), extended to 64 bits. The tick clock
+// is monotonic: setting the time does not affect it. Safe to call from any context.
+uint64_t nrf_cal_get_ticks(void);
+
+// Returns the time as seconds since 1970-01-01 00:00:00 UTC, cheap enough for every sample.
+// Turn the calibration on/off by setting the calibrated parameter; without calibration data
+// both are the same. Use civil_time_format() to print it.
+uint32_t nrf_cal_get_epoch(bool calibrated);
+
+// Returns true while the time cannot be trusted: it was never set, or it was restored after
+// a reset, so it runs late by up to 512 s (retained RAM) or by however long the device was
+// off (flash). Setting the time clears it.
+bool nrf_cal_time_uncertain(void);
 
-// Returns the calibrated time as a tm struct. If no calibration data is available it will return the uncalibrated time.
-struct tm *nrf_cal_get_time_calibrated(void);
+// Takes the current state, e.g. to save it in flash.
+void nrf_cal_state_get(nrf_cal_state_t * p_state);
 
-// Returns a string for printing the date and time. Turn the calibration on/off by setting the calibrate parameter. 
-char *nrf_cal_get_time_string(bool calibrated);
+// Call once after nrf_cal_init(). If the calendar did not come through the reset in retained
+// RAM, it continues from p_state (may be NULL). Either way the time is uncertain, and it
+// is moved forward to min_epoch if it is behind, e.g. to the newest logged timestamp, so
+// timestamps never run backwards over a reset.
+void nrf_cal_restore(nrf_cal_state_t const * p_state, uint32_t min_epoch);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "radio_config.h"
+#include "radio_frame.h"
+#include "nrf.h"
+
+typedef struct
+{
+    char const * p_name;
+    uint32_t     mode;              /**< RADIO_MODE_MODE_* value. */
+    uint32_t     pcnf0;             /**< Preamble and, for the Coded PHY, CI and TERM fields. */
+    uint32_t     header_us;         /**< Air time of the fields before the length field. */
+    uint32_t     ns_per_bit;        /**< Air time of a bit from the length field on. */
+    uint32_t     tail_bits;         /**< Bits sent after the CRC. */
+} radio_profile_t;
+
+// Coded PHY: 80 µs preamble, then the access address, CI and TERM1 always at S=8.
+static radio_profile_t const m_profiles[RADIO_CONFIG_PROFILE_COUNT] =
+{
+    [RADIO_CONFIG_PROFILE_1MBIT] =
+    {
+        "1m", RADIO_MODE_MODE_Nrf_1Mbit,
+        RADIO_PCNF0_PLEN_8bit << RADIO_PCNF0_PLEN_Pos,
+        (1 + 4) * 8, 1000, 0
+    },
+    [RADIO_CONFIG_PROFILE_2MBIT] =
+    {
+        "2m", RADIO_MODE_MODE_Nrf_2Mbit,
+        RADIO_PCNF0_PLEN_16bit << RADIO_PCNF0_PLEN_Pos,
+        (2 + 4) * 8 / 2, 500, 0
+    },
+    [RADIO_CONFIG_PROFILE_LR500] =
+    {
+        "lr500", RADIO_MODE_MODE_Ble_LR500Kbit,
+        (RADIO_PCNF0_PLEN_LongRange << RADIO_PCNF0_PLEN_Pos) | (2 << RADIO_PCNF0_CILEN_Pos) | (3 << RADIO_PCNF0_TERMLEN_Pos),
+        80 + (32 + 2 + 3) * 8, 2000, 3
+    },
+    [RADIO_CONFIG_PROFILE_LR125] =
+    {
+        "lr125", RADIO_MODE_MODE_Ble_LR125Kbit,
+        (RADIO_PCNF0_PLEN_LongRange << RADIO_PCNF0_PLEN_Pos) | (2 << RADIO_PCNF0_CILEN_Pos) | (3 << RADIO_PCNF0_TERMLEN_Pos),
+        80 + (32 + 2 + 3) * 8, 8000, 3
+    },
+};
+
+static radio_config_profile_t m_profile = RADIO_CONFIG_DEFAULT_PROFILE;
+
+void radio_configure(void)
+{
+    radio_profile_t const * p_profile = &m_profiles[m_profile];
+
+    NRF_RADIO->TXPOWER     = RADIO_TXPOWER_TXPOWER_0dBm << RADIO_TXPOWER_TXPOWER_Pos;
+    NRF_RADIO->FREQUENCY   = RADIO_CONFIG_FREQUENCY;
+    NRF_RADIO->MODE        = p_profile->mode << RADIO_MODE_MODE_Pos;
+    NRF_RADIO->MODECNF0    = (RADIO_MODECNF0_RU_Fast << RADIO_MODECNF0_RU_Pos) |
+                             (RADIO_MODECNF0_DTX_Center << RADIO_MODECNF0_DTX_Pos);
+
+    NRF_RADIO->PREFIX0     = (uint32_t)RADIO_CONFIG_ADDRESS >> 24;
+    NRF_RADIO->BASE0       = (uint32_t)RADIO_CONFIG_ADDRESS << 8;
+    NRF_RADIO->TXADDRESS   = 0;
+    NRF_RADIO->RXADDRESSES = RADIO_RXADDRESSES_ADDR0_Msk;
+
+    // Frames carry their length in an 8-bit field in front of the payload.
+    NRF_RADIO->PCNF0 = p_profile->pcnf0 | (8 << RADIO_PCNF0_LFLEN_Pos);
+    NRF_RADIO->PCNF1 = (RADIO_PCNF1_WHITEEN_Enabled << RADIO_PCNF1_WHITEEN_Pos) |
+                       (RADIO_PCNF1_ENDIAN_Little << RADIO_PCNF1_ENDIAN_Pos)    |
+                       (3 << RADIO_PCNF1_BALEN_Pos)                             |
+                       (RADIO_FRAME_MAX_SIZE << RADIO_PCNF1_MAXLEN_Pos);
+    NRF_RADIO->DATAWHITEIV = RADIO_CONFIG_FREQUENCY;
+
+    NRF_RADIO->CRCCNF  = (RADIO_CRCCNF_LEN_Three << RADIO_CRCCNF_LEN_Pos) |
+                         (RADIO_CRCCNF_SKIPADDR_Skip << RADIO_CRCCNF_SKIPADDR_Pos);
+    NRF_RADIO->CRCPOLY = 0x0000065B;
+    NRF_RADIO->CRCINIT = 0x00555555;
+}
+
+void radio_config_profile_set(radio_config_profile_t profile)
+{
+    if (profile < RADIO_CONFIG_PROFILE_COUNT)
+    {
+        m_profile = profile;
+        radio_configure();
+    }
+}
+
+radio_config_profile_t radio_config_profile_get(void)
+{
+    return m_profile;
+}
+
+char const * radio_config_profile_name(radio_config_profile_t profile)
+{
+    return m_profiles[profile].p_name;
+}
+
+uint32_t radio_config_air_time(radio_config_profile_t profile, uint32_t size)
+{
+    radio_profile_t const * p_profile = &m_profiles[profile];
+    uint32_t                bits      = (1 + size + RADIO_CONFIG_CRC_SIZE) * 8 + p_profile->tail_bits;
+
+    return RADIO_CONFIG_RAMP_UP_US + p_profile->header_us + (bits * p_profile->ns_per_bit + 999) / 1000;
+}
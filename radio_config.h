@@ -0,0 +1,47 @@
+#ifndef RADIO_CONFIG_H__
+#define RADIO_CONFIG_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Radio setup for the fridgemon frames.
+ *
+ * All profiles share the channel, address and packet format: a 4-byte address, an 8-bit
+ * length field, up to RADIO_FRAME_MAX_SIZE payload bytes and a 24-bit CRC, whitened. They
+ * differ in the PHY only, trading range for air time: the Coded PHY profiles are BLE Long
+ * Range (S=2 and S=8), for reaching a gateway through the walls of a steel container.
+ */
+
+#define RADIO_CONFIG_FREQUENCY      (7u)        /**< 2407 MHz, between the BLE channels. */
+#define RADIO_CONFIG_ADDRESS        (0x71764129u) /**< Prefix in the top byte, base below. */
+#define RADIO_CONFIG_CRC_SIZE       (3u)
+#define RADIO_CONFIG_RAMP_UP_US     (40u)       /**< Fast ramp-up. */
+
+typedef enum
+{
+    RADIO_CONFIG_PROFILE_1MBIT,     /**< Proprietary 1 Mbit/s. */
+    RADIO_CONFIG_PROFILE_2MBIT,     /**< Proprietary 2 Mbit/s, shortest air time. */
+    RADIO_CONFIG_PROFILE_LR500,     /**< BLE Long Range 500 kbit/s (Coded PHY, S=2). */
+    RADIO_CONFIG_PROFILE_LR125,     /**< BLE Long Range 125 kbit/s (Coded PHY, S=8), longest range. */
+    RADIO_CONFIG_PROFILE_COUNT
+} radio_config_profile_t;
+
+#define RADIO_CONFIG_DEFAULT_PROFILE    RADIO_CONFIG_PROFILE_1MBIT
+
+// Configures the radio with the active profile, RADIO_CONFIG_DEFAULT_PROFILE after a reset.
+void radio_configure(void);
+
+// Switches to another profile. The radio must be disabled.
+void radio_config_profile_set(radio_config_profile_t profile);
+
+radio_config_profile_t radio_config_profile_get(void);
+
+// Returns the name of a profile, as used by the CLI.
+char const * radio_config_profile_name(radio_config_profile_t profile);
+
+// Returns the time in µs the transmitter is on for one packet with a payload of size bytes,
+// ramp-up included.
+uint32_t radio_config_air_time(radio_config_profile_t profile, uint32_t size);
+
+#endif // RADIO_CONFIG_H__
@@ -0,0 +1,112 @@
+#include "radio_frame.h"
+
+static void half_put(uint8_t * p_data, uint16_t half)
+{
+    p_data[0] = (uint8_t)half;
+    p_data[1] = (uint8_t)(half >> 8);
+}
+
+static void word_put(uint8_t * p_data, uint32_t word)
+{
+    half_put(p_data, (uint16_t)word);
+    half_put(p_data + 2, (uint16_t)(word >> 16));
+}
+
+static uint16_t half_get(uint8_t const * p_data)
+{
+    return (uint16_t)(p_data[0] | (p_data[1] << 8));
+}
+
+static uint32_t word_get(uint8_t const * p_data)
+{
+    return half_get(p_data) | ((uint32_t)half_get(p_data + 2) << 16);
+}
+
+static void header_put(uint8_t * p_buf, radio_frame_header_t const * p_header)
+{
+    p_buf[0] = p_header->type;
+    p_buf[1] = p_header->flags;
+    p_buf[2] = p_header->count;
+    p_buf[3] = 0;
+    word_put(&p_buf[4], p_header->device_id);
+    word_put(&p_buf[8], p_header->sequence);
+    word_put(&p_buf[12], p_header->timestamp);
+}
+
+uint32_t radio_frame_encode(uint8_t                  * p_buf,
+                            radio_frame_header_t     * p_header,
+                            flash_log_sample_t const * p_samples,
+                            uint32_t                   count)
+{
+    uint8_t * p_sample = &p_buf[RADIO_FRAME_HEADER_SIZE];
+    uint32_t  n;
+
+    if (count > RADIO_FRAME_MAX_SAMPLES)
+    {
+        count = RADIO_FRAME_MAX_SAMPLES;
+    }
+
+    p_header->timestamp = (count > 0) ? p_samples[0].timestamp : 0;
+    for (n = 0; n < count; n++)
+    {
+        uint32_t offset = p_samples[n].timestamp - p_header->timestamp;
+
+        if (offset > RADIO_FRAME_MAX_SPAN)
+        {
+            break;
+        }
+        half_put(p_sample, (uint16_t)offset);
+        half_put(p_sample + 2, (uint16_t)(int16_t)p_samples[n].temperature);
+        p_sample += RADIO_FRAME_SAMPLE_SIZE;
+    }
+    p_header->count = (uint8_t)n;
+
+    header_put(p_buf, p_header);
+
+    return RADIO_FRAME_HEADER_SIZE + n * RADIO_FRAME_SAMPLE_SIZE;
+}
+
+uint32_t radio_frame_ack_encode(uint8_t * p_buf, radio_frame_header_t const * p_header)
+{
+    radio_frame_header_t ack = *p_header;
+
+    ack.type  = RADIO_FRAME_TYPE_ACK;
+    ack.flags = 0;
+    ack.count = 0;
+    header_put(p_buf, &ack);
+
+    return RADIO_FRAME_HEADER_SIZE;
+}
+
+bool radio_frame_decode(uint8_t const * p_buf, uint32_t size, radio_frame_header_t * p_header)
+{
+    if ((size < RADIO_FRAME_HEADER_SIZE) || (size > RADIO_FRAME_MAX_SIZE))
+    {
+        return false;
+    }
+
+    p_header->type      = p_buf[0];
+    p_header->flags     = p_buf[1];
+    p_header->count     = p_buf[2];
+    p_header->device_id = word_get(&p_buf[4]);
+    p_header->sequence  = word_get(&p_buf[8]);
+    p_header->timestamp = word_get(&p_buf[12]);
+
+    if (p_header->type == RADIO_FRAME_TYPE_ACK)
+    {
+        return (p_header->count == 0) && (size == RADIO_FRAME_HEADER_SIZE);
+    }
+    return (p_header->type == RADIO_FRAME_TYPE_SAMPLES) &&
+           (size == RADIO_FRAME_HEADER_SIZE + p_header->count * RADIO_FRAME_SAMPLE_SIZE);
+}
+
+void radio_frame_sample_get(uint8_t const              * p_buf,
+                            radio_frame_header_t const * p_header,
+                            uint32_t                     index,
+                            flash_log_sample_t         * p_sample)
+{
+    uint8_t const * p_data = &p_buf[RADIO_FRAME_HEADER_SIZE + index * RADIO_FRAME_SAMPLE_SIZE];
+
+    p_sample->timestamp   = p_header->timestamp + half_get(p_data);
+    p_sample->temperature = (int16_t)half_get(p_data + 2);
+}
@@ -0,0 +1,71 @@
+#ifndef RADIO_FRAME_H__
+#define RADIO_FRAME_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_log.h"
+
+/**
+ * @brief Radio frame carrying a batch of samples.
+ *
+ * One frame fills one radio packet of up to RADIO_FRAME_MAX_SIZE payload bytes:
+ *
+ *   type | flags | sample count | reserved | device ID (32 bit) | sequence (32 bit) |
+ *   base timestamp (32 bit) | samples
+ *
+ * Every sample takes four bytes: its time after the base timestamp in seconds (16 bit)
+ * and the temperature in 0.25 °C units (signed 16 bit). All multi-byte fields are little
+ * endian. The sequence number is counted per device and identifies the frame, so a
+ * receiver can drop duplicates. Integrity is left to the radio CRC.
+ *
+ * The receiver answers every sample frame with an ACK frame: the same header with the
+ * ACK type, no samples and the device ID, sequence number and base timestamp copied.
+ *
+ * This module is plain C and is shared by the firmware and the host tools in tools/.
+ */
+
+#define RADIO_FRAME_MAX_SIZE        (255u)      /**< Largest radio payload of the nRF52840. */
+#define RADIO_FRAME_HEADER_SIZE     (16u)
+#define RADIO_FRAME_SAMPLE_SIZE     (4u)
+#define RADIO_FRAME_MAX_SAMPLES     ((RADIO_FRAME_MAX_SIZE - RADIO_FRAME_HEADER_SIZE) / RADIO_FRAME_SAMPLE_SIZE)
+#define RADIO_FRAME_MAX_SPAN        (0xFFFFu)   /**< Largest sample time after the base timestamp. */
+
+#define RADIO_FRAME_TYPE_SAMPLES    (0x01)
+#define RADIO_FRAME_TYPE_ACK        (0x02)
+
+#define RADIO_FRAME_FLAG_TIME_UNCERTAIN (0x01)  /**< Timestamps taken while the clock was not trusted. */
+
+typedef struct
+{
+    uint8_t  type;                  /**< RADIO_FRAME_TYPE_* value. */
+    uint8_t  flags;                 /**< RADIO_FRAME_FLAG_* bits. */
+    uint8_t  count;                 /**< Number of samples. */
+    uint32_t device_id;
+    uint32_t sequence;
+    uint32_t timestamp;             /**< Timestamp of the first sample. */
+} radio_frame_header_t;
+
+// Encodes as many of count samples as fit into a frame at p_buf, which must hold
+// RADIO_FRAME_MAX_SIZE bytes. A frame ends early at a sample older than the first one or
+// more than RADIO_FRAME_MAX_SPAN seconds after it. The count and timestamp of p_header
+// are filled in. Returns the frame size in bytes.
+uint32_t radio_frame_encode(uint8_t                  * p_buf,
+                            radio_frame_header_t     * p_header,
+                            flash_log_sample_t const * p_samples,
+                            uint32_t                   count);
+
+// Encodes the ACK of a sample frame with the given header into p_buf, which must hold
+// RADIO_FRAME_HEADER_SIZE bytes. Returns the frame size in bytes.
+uint32_t radio_frame_ack_encode(uint8_t * p_buf, radio_frame_header_t const * p_header);
+
+// Decodes the header of a frame of the given size. Returns false if it is not a
+// well-formed sample or ACK frame.
+bool radio_frame_decode(uint8_t const * p_buf, uint32_t size, radio_frame_header_t * p_header);
+
+// Decodes sample number index (below p_header->count) of a decoded frame.
+void radio_frame_sample_get(uint8_t const              * p_buf,
+                            radio_frame_header_t const * p_header,
+                            uint32_t                     index,
+                            flash_log_sample_t         * p_sample);
+
+#endif // RADIO_FRAME_H__
@@ -0,0 +1,122 @@
+#include <string.h>
+#include "radio_link.h"
+
+// Tops the batch up from the log. A batch ends where the time certainty changes, like
+// the log blocks it comes from.
+static void batch_fill(radio_link_t * p_link)
+{
+    while ((p_link->batch_len < RADIO_FRAME_MAX_SAMPLES) && (p_link->remaining > 0))
+    {
+        flash_log_cursor_t         cursor = p_link->cursor;
+        flash_log_sample_t const * p_sample;
+        bool                       uncertain;
+
+        if (flash_log_cursor_next(&cursor, &p_sample) != FLASH_LOG_SUCCESS)
+        {
+            p_link->remaining = 0;
+            break;
+        }
+        uncertain = flash_log_cursor_time_uncertain(&cursor);
+        if ((p_link->batch_len > 0) && (uncertain != p_link->batch_uncertain))
+        {
+            break;
+        }
+
+        flash_log_cursor_position_get(&cursor, &p_link->batch_positions[p_link->batch_len]);
+        p_link->batch[p_link->batch_len++] = *p_sample;
+        p_link->batch_uncertain            = uncertain;
+        p_link->cursor                     = cursor;
+        p_link->remaining--;
+    }
+}
+
+void radio_link_init(radio_link_t * p_link, uint32_t device_id, uint32_t sequence)
+{
+    memset(p_link, 0, sizeof(*p_link));
+    p_link->state     = RADIO_LINK_IDLE;
+    p_link->device_id = device_id;
+    p_link->sequence  = sequence;
+}
+
+void radio_link_start(radio_link_t * p_link, flash_log_cursor_t const * p_cursor, uint32_t count)
+{
+    p_link->state         = RADIO_LINK_BUSY;
+    p_link->cursor        = *p_cursor;
+    p_link->remaining     = count;
+    p_link->batch_len     = 0;
+    p_link->frame_size    = 0;
+    p_link->acked         = false;
+    p_link->frames_sent   = 0;
+    p_link->retransmits   = 0;
+    p_link->samples_acked = 0;
+}
+
+uint32_t radio_link_frame_get(radio_link_t * p_link, uint8_t const ** pp_frame)
+{
+    if (p_link->state != RADIO_LINK_BUSY)
+    {
+        return 0;
+    }
+
+    if (p_link->frame_size > 0)
+    {
+        if (p_link->attempts >= RADIO_LINK_MAX_ATTEMPTS)
+        {
+            p_link->state = RADIO_LINK_FAILED;
+            return 0;
+        }
+        p_link->retransmits++;
+    }
+    else
+    {
+        batch_fill(p_link);
+        if (p_link->batch_len == 0)
+        {
+            p_link->state = RADIO_LINK_DONE;
+            return 0;
+        }
+
+        p_link->header.type      = RADIO_FRAME_TYPE_SAMPLES;
+        p_link->header.flags     = p_link->batch_uncertain ? RADIO_FRAME_FLAG_TIME_UNCERTAIN : 0;
+        p_link->header.device_id = p_link->device_id;
+        p_link->header.sequence  = p_link->sequence++;
+        p_link->frame_size = radio_frame_encode(p_link->frame, &p_link->header, p_link->batch, p_link->batch_len);
+        p_link->frame_last          = p_link->batch[p_link->header.count - 1].timestamp;
+        p_link->frame_last_position = p_link->batch_positions[p_link->header.count - 1];
+        p_link->attempts            = 0;
+
+        p_link->batch_len -= p_link->header.count;
+        memmove(p_link->batch,
+                &p_link->batch[p_link->header.count],
+                p_link->batch_len * sizeof(p_link->batch[0]));
+        memmove(p_link->batch_positions,
+                &p_link->batch_positions[p_link->header.count],
+                p_link->batch_len * sizeof(p_link->batch_positions[0]));
+    }
+
+    p_link->attempts++;
+    p_link->frames_sent++;
+    *pp_frame = p_link->frame;
+    return p_link->frame_size;
+}
+
+bool radio_link_reply_put(radio_link_t * p_link, uint8_t const * p_packet, uint32_t size)
+{
+    radio_frame_header_t header;
+
+    if ((p_link->frame_size == 0) ||
+        !radio_frame_decode(p_packet, size, &header) ||
+        (header.type != RADIO_FRAME_TYPE_ACK) ||
+        (header.device_id != p_link->header.device_id) ||
+        (header.sequence != p_link->header.sequence))
+    {
+        return false;
+    }
+
+    p_link->frame_size       = 0;
+    p_link->acked            = true;
+    p_link->acked_position   = p_link->frame_last_position;
+    p_link->acked_timestamp  = p_link->frame_last;
+    p_link->samples_acked   += p_link->header.count;
+    return true;
+}
@@ -0,0 +1,81 @@
+#ifndef RADIO_LINK_H__
+#define RADIO_LINK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_log.h"
+#include "radio_frame.h"
+
+/**
+ * @brief Stop-and-wait transfer of log samples over the radio.
+ *
+ * Every sample frame is answered by an ACK frame carrying its device ID and sequence
+ * number. A frame that is not acknowledged within the reply window is sent again with the
+ * same sequence number, so the receiver can drop the copies it already has, up to
+ * RADIO_LINK_MAX_ATTEMPTS times in all; then the transfer fails. The samples are read
+ * from the log as the transfer goes, one frame ahead at most.
+ *
+ * The log position of the newest acknowledged sample is the resume point: a later transfer
+ * places the cursor after it with flash_log_cursor_seek_position() and picks up where the
+ * last one stopped, even if the clock was set back in between. The frame in flight when a
+ * transfer failed may have arrived with only its ACKs lost; the resumed transfer starts
+ * with the same samples, so a receiver drops those at the start of a frame with the same
+ * base timestamp as the last one it took from the device (see gateway.h).
+ *
+ * The radio itself is driven by the caller, which makes this module plain C; it is shared
+ * with tools/radiosim.
+ */
+
+#define RADIO_LINK_MAX_ATTEMPTS     (8u)        /**< Transmissions of a frame before giving up. */
+#define RADIO_LINK_TURNAROUND_US    (200u)      /**< Time the receiver takes to start its ACK. */
+
+typedef enum
+{
+    RADIO_LINK_IDLE,
+    RADIO_LINK_BUSY,                /**< Samples or an unacknowledged frame left. */
+    RADIO_LINK_DONE,                /**< Every sample acknowledged. */
+    RADIO_LINK_FAILED               /**< A frame went unacknowledged RADIO_LINK_MAX_ATTEMPTS times. */
+} radio_link_state_t;
+
+typedef struct
+{
+    radio_link_state_t   state;
+    uint32_t             device_id;
+    uint32_t             sequence;          /**< Sequence number of the next new frame. */
+    flash_log_cursor_t   cursor;
+    uint32_t             remaining;         /**< Samples not yet read from the log. */
+    flash_log_sample_t   batch[RADIO_FRAME_MAX_SAMPLES];
+    flash_log_position_t batch_positions[RADIO_FRAME_MAX_SAMPLES];   /**< Where the batch samples are in the log. */
+    uint32_t             batch_len;
+    bool                 batch_uncertain;
+    uint8_t              frame[RADIO_FRAME_MAX_SIZE];
+    uint32_t             frame_size;        /**< Size of the frame awaiting its ACK, 0 if none. */
+    uint32_t             frame_last;        /**< Timestamp of the newest sample in that frame. */
+    flash_log_position_t frame_last_position; /**< Log position of that sample. */
+    radio_frame_header_t header;            /**< Header of that frame. */
+    uint32_t             attempts;          /**< Transmissions of that frame so far. */
+    bool                 acked;             /**< acked_position and acked_timestamp are set. */
+    flash_log_position_t acked_position;    /**< Newest acknowledged sample, the resume point. */
+    uint32_t             acked_timestamp;   /**< Its timestamp, for display. */
+    uint32_t             frames_sent;       /**< Transmissions, retransmissions included. */
+    uint32_t             retransmits;
+    uint32_t             samples_acked;
+} radio_link_t;
+
+// Sets the identity of the sender. The first sequence number should be random, so that
+// frames sent after a reset do not look like copies of earlier ones.
+void radio_link_init(radio_link_t * p_link, uint32_t device_id, uint32_t sequence);
+
+// Starts a transfer of up to count samples following the cursor position.
+void radio_link_start(radio_link_t * p_link, flash_log_cursor_t const * p_cursor, uint32_t count);
+
+// Returns the next frame to send, after the ACK of the previous frame or the end of its
+// reply window: the unacknowledged frame again, or a new one. Returns 0 when the
+// transfer is over, see radio_link_t::state.
+uint32_t radio_link_frame_get(radio_link_t * p_link, uint8_t const ** pp_frame);
+
+// Takes a packet received in the reply window. Returns true if it acknowledges the frame
+// last sent.
+bool radio_link_reply_put(radio_link_t * p_link, uint8_t const * p_packet, uint32_t size);
+
+#endif // RADIO_LINK_H__
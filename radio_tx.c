@@ -0,0 +1,290 @@
+#include <string.h>
+#include "radio_tx.h"
+#include "radio_frame.h"
+#include "nrf_calendar.h"
+#include "nrf.h"
+#include "app_util_platform.h"
+
+// Every slot holds the length field followed by the frame, in RAM for EasyDMA.
+static uint8_t            m_queue[RADIO_TX_QUEUE_SIZE][1 + RADIO_FRAME_MAX_SIZE];
+static volatile uint32_t  m_head = 0;          /**< Frames sent, advanced by the interrupt. */
+static volatile uint32_t  m_tail = 0;          /**< Frames queued, advanced by radio_tx_put(). */
+static volatile bool      m_busy = false;      /**< A transmission is under way. */
+static radio_tx_handler_t m_handler;
+
+// Packet received, length field first.
+static uint8_t                             m_rx[1 + RADIO_FRAME_MAX_SIZE];
+
+// Reply window of the frame sent by radio_tx_request().
+static radio_tx_reply_handler_t volatile   m_reply_handler = NULL;   /**< Set while a request is under way. */
+static uint32_t                            m_reply_timeout;
+static volatile bool                       m_listening = false;      /**< The reply window is open. */
+static volatile bool                       m_timed_out = false;
+
+// Receive mode, see radio_tx_receive_set().
+static radio_tx_receive_handler_t volatile m_receive_handler = NULL;
+static volatile bool                       m_receiving = false;      /**< The radio is receiving in receive mode. */
+
+// Starts the high frequency crystal oscillator (HFXO) the radio needs, unless it runs. The
+// startup, a fraction of a millisecond, is waited out once per burst of radio activity.
+static void hfxo_start(void)
+{
+    uint32_t running = CLOCK_HFCLKSTAT_SRC_Msk | CLOCK_HFCLKSTAT_STATE_Msk;
+
+    if ((NRF_CLOCK->HFCLKSTAT & running) != running)
+    {
+        NRF_CLOCK->EVENTS_HFCLKSTARTED = 0;
+        NRF_CLOCK->TASKS_HFCLKSTART    = 1;
+        while (NRF_CLOCK->EVENTS_HFCLKSTARTED == 0)
+        {
+            // Do nothing.
+        }
+    }
+}
+
+// Falls back to the internal oscillator once the radio is idle.
+static void hfxo_stop(void)
+{
+    NRF_CLOCK->TASKS_HFCLKSTOP = 1;
+}
+
+static void tx_start(void)
+{
+    NRF_RADIO->PACKETPTR       = (uint32_t)m_queue[m_head % RADIO_TX_QUEUE_SIZE];
+    NRF_RADIO->EVENTS_DISABLED = 0;
+    NRF_RADIO->TASKS_TXEN      = 1;
+}
+
+static void rx_start(void)
+{
+    NRF_RADIO->PACKETPTR  = (uint32_t)m_rx;
+    NRF_RADIO->EVENTS_END = 0;
+    NRF_RADIO->TASKS_RXEN = 1;
+}
+
+// Returns true if the radio was disabled by the end of a packet with a good CRC.
+static bool rx_done(void)
+{
+    return (NRF_RADIO->EVENTS_END != 0) &&
+           (NRF_RADIO->CRCSTATUS == (RADIO_CRCSTATUS_CRCSTATUS_CRCOk << RADIO_CRCSTATUS_CRCSTATUS_Pos));
+}
+
+// Starts what comes next once the radio is disabled: a queued frame, receive mode or nothing.
+static void next_start(void)
+{
+    if (m_head != m_tail)
+    {
+        tx_start();
+    }
+    else if (m_receive_handler != NULL)
+    {
+        m_receiving = true;
+        rx_start();
+    }
+    else
+    {
+        m_busy = false;
+        hfxo_stop();
+    }
+}
+
+// Calendar callback closing the reply window. It preempts the RADIO interrupt, which
+// finishes the window once the radio is disabled.
+static void reply_timeout(void)
+{
+    nrf_cal_set_channel_callback(NRF_CAL_CHANNEL_RADIO, NULL, 0);
+    if (m_listening)
+    {
+        m_timed_out = true;
+        NRF_RADIO->TASKS_DISABLE = 1;
+    }
+}
+
+static void reply_start(void)
+{
+    m_listening = true;
+    m_timed_out = false;
+
+    rx_start();
+    nrf_cal_set_channel_callback(NRF_CAL_CHANNEL_RADIO, reply_timeout, m_reply_timeout);
+}
+
+// Called with the radio disabled after receiving in the reply window.
+static void reply_end(void)
+{
+    radio_tx_reply_handler_t reply_handler = m_reply_handler;
+    bool                     received      = rx_done();
+
+    // A corrupted packet is dropped and the window stays open, unless it has just closed.
+    CRITICAL_REGION_ENTER();
+    if (!received && !m_timed_out)
+    {
+        rx_start();
+        reply_handler = NULL;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (reply_handler == NULL)
+    {
+        return;
+    }
+
+    nrf_cal_set_channel_callback(NRF_CAL_CHANNEL_RADIO, NULL, 0);
+    m_listening     = false;
+    m_reply_handler = NULL;
+    next_start();
+
+    reply_handler(&m_rx[1], received ? m_rx[0] : 0);
+}
+
+// Called with the radio disabled after receiving in receive mode. The reply, if any, goes
+// straight to the queue, which only the interrupt fills in receive mode.
+static void receive_end(void)
+{
+    radio_tx_receive_handler_t handler = m_receive_handler;
+    uint8_t                  * p_slot  = NULL;
+    uint32_t                   size;
+
+    m_receiving = false;
+    if ((handler != NULL) && rx_done())
+    {
+        if (m_tail - m_head < RADIO_TX_QUEUE_SIZE)
+        {
+            p_slot = m_queue[m_tail % RADIO_TX_QUEUE_SIZE];
+        }
+        size = handler(&m_rx[1], m_rx[0], (p_slot != NULL) ? &p_slot[1] : NULL);
+        if ((p_slot != NULL) && (size > 0) && (size <= RADIO_FRAME_MAX_SIZE))
+        {
+            p_slot[0] = (uint8_t)size;
+            m_tail++;
+        }
+    }
+    next_start();
+}
+
+void radio_tx_init(radio_tx_handler_t handler)
+{
+    m_handler = handler;
+
+    NRF_RADIO->SHORTS   = RADIO_SHORTS_READY_START_Msk | RADIO_SHORTS_END_DISABLE_Msk;
+    NRF_RADIO->INTENSET = RADIO_INTENSET_DISABLED_Msk;
+    NVIC_ClearPendingIRQ(RADIO_IRQn);
+    NVIC_SetPriority(RADIO_IRQn, RADIO_TX_IRQ_PRIORITY);
+    NVIC_EnableIRQ(RADIO_IRQn);
+}
+
+bool radio_tx_put(uint8_t const * p_frame, uint32_t size)
+{
+    uint8_t * p_slot;
+
+    if ((m_tail - m_head >= RADIO_TX_QUEUE_SIZE) || (size > RADIO_FRAME_MAX_SIZE) ||
+        (m_receive_handler != NULL))
+    {
+        return false;
+    }
+
+    p_slot    = m_queue[m_tail % RADIO_TX_QUEUE_SIZE];
+    p_slot[0] = (uint8_t)size;
+    memcpy(&p_slot[1], p_frame, size);
+
+    // Wait for the crystal outside the critical region. The radio may still go idle and
+    // stop it before the region is entered, so it is checked again inside.
+    if (!m_busy)
+    {
+        hfxo_start();
+    }
+
+    CRITICAL_REGION_ENTER();
+    m_tail++;
+    if (!m_busy)
+    {
+        m_busy = true;
+        hfxo_start();
+        tx_start();
+    }
+    CRITICAL_REGION_EXIT();
+
+    return true;
+}
+
+bool radio_tx_request(uint8_t const *           p_frame,
+                      uint32_t                  size,
+                      uint32_t                  timeout,
+                      radio_tx_reply_handler_t  reply_handler)
+{
+    if (radio_tx_pending() > 0)
+    {
+        return false;
+    }
+
+    m_reply_handler = reply_handler;
+    m_reply_timeout = timeout;
+    if (!radio_tx_put(p_frame, size))
+    {
+        m_reply_handler = NULL;
+        return false;
+    }
+    return true;
+}
+
+void radio_tx_receive_set(radio_tx_receive_handler_t handler)
+{
+    if ((handler != NULL) && !m_busy)
+    {
+        hfxo_start();
+    }
+
+    CRITICAL_REGION_ENTER();
+    m_receive_handler = handler;
+    if ((handler != NULL) && !m_busy)
+    {
+        m_busy = true;
+        hfxo_start();
+        next_start();
+    }
+    else if ((handler == NULL) && m_receiving)
+    {
+        // The interrupt leaves receive mode once the radio is disabled.
+        NRF_RADIO->TASKS_DISABLE = 1;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+uint32_t radio_tx_pending(void)
+{
+    return (m_tail - m_head) + (m_listening ? 1 : 0);
+}
+
+void RADIO_IRQHandler(void)
+{
+    if (NRF_RADIO->EVENTS_DISABLED == 0)
+    {
+        return;
+    }
+
+    NRF_RADIO->EVENTS_DISABLED = 0;
+    if (m_listening)
+    {
+        reply_end();
+        return;
+    }
+    if (m_receiving)
+    {
+        receive_end();
+        return;
+    }
+
+    m_head++;
+    if (m_reply_handler != NULL)
+    {
+        // The request is out; the radio stays busy for the reply window.
+        reply_start();
+        return;
+    }
+    next_start();
+
+    if (m_handler != NULL)
+    {
+        m_handler();
+    }
+}
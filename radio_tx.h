@@ -0,0 +1,66 @@
+#ifndef RADIO_TX_H__
+#define RADIO_TX_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Interrupt-driven radio transmitter with a frame queue.
+ *
+ * The READY_START and END_DISABLE shortcuts run a whole transmission in hardware; the
+ * RADIO interrupt only fires once the radio is disabled again, to start the next queued
+ * frame. The CPU sleeps for the air time, and the caller is free to queue the next frames
+ * while one is on air.
+ *
+ * A frame sent with radio_tx_request() is followed by a reply window: the radio turns to
+ * receive until a packet with a good CRC arrives or the window, timed by the
+ * NRF_CAL_CHANNEL_RADIO channel of the calendar, closes.
+ *
+ * In receive mode, used by a gateway, the radio receives whenever it has nothing to send
+ * and every packet can be answered at once from the interrupt.
+ *
+ * The high frequency crystal oscillator (HFXO) the radio needs is started when the radio
+ * leaves idle and stopped as soon as the queue drains and no reply window or receive mode
+ * is open, so it only draws current around radio activity.
+ *
+ * The radio must be configured (frequency, addresses, packet format with an 8-bit length
+ * field) before the first frame is queued.
+ */
+
+#define RADIO_TX_IRQ_PRIORITY       6
+#define RADIO_TX_QUEUE_SIZE         4
+
+// Called from the RADIO interrupt after every frame sent without a reply window, when a
+// queue slot has come free.
+typedef void (*radio_tx_handler_t)(void);
+
+// Called from the RADIO interrupt when a reply window closes, with the packet received or
+// with size 0 if none arrived in time.
+typedef void (*radio_tx_reply_handler_t)(uint8_t const * p_packet, uint32_t size);
+
+// Called from the RADIO interrupt with every packet received in receive mode. A reply
+// written to p_reply, which holds RADIO_FRAME_MAX_SIZE bytes, is sent right away. p_reply
+// is NULL if the queue is full. Returns the size of the reply, 0 for none.
+typedef uint32_t (*radio_tx_receive_handler_t)(uint8_t const * p_packet, uint32_t size, uint8_t * p_reply);
+
+// Sets up the shortcuts and enables the RADIO interrupt. handler may be NULL.
+void radio_tx_init(radio_tx_handler_t handler);
+
+// Copies a frame of up to RADIO_FRAME_MAX_SIZE bytes to the queue and starts sending if
+// the radio is idle. Returns false if the queue is full or receive mode is on.
+bool radio_tx_put(uint8_t const * p_frame, uint32_t size);
+
+// Sends a frame like radio_tx_put(), then listens for a reply for timeout ticks of the
+// calendar. Returns false if the queue is not empty.
+bool radio_tx_request(uint8_t const *           p_frame,
+                      uint32_t                  size,
+                      uint32_t                  timeout,
+                      radio_tx_reply_handler_t  reply_handler);
+
+// Turns receive mode on with the given handler, or off with NULL.
+void radio_tx_receive_set(radio_tx_receive_handler_t handler);
+
+// Returns the number of frames queued or on air, including a frame awaiting its reply.
+uint32_t radio_tx_pending(void);
+
+#endif // RADIO_TX_H__
@@ -0,0 +1,59 @@
+#include <math.h>
+#include <string.h>
+#include "stats.h"
+
+#define STATS_KELVIN_OFFSET     (273.15)
+#define STATS_KELVIN_OFFSET_F   (273.15f)
+
+void stats_reset(stats_t * p_stats)
+{
+    memset(p_stats, 0, sizeof(*p_stats));
+}
+
+void stats_update(stats_t * p_stats, int32_t temperature)
+{
+    double delta;
+
+    if ((p_stats->count == 0) || (temperature < p_stats->min))
+    {
+        p_stats->min = (int16_t)temperature;
+    }
+    if ((p_stats->count == 0) || (temperature > p_stats->max))
+    {
+        p_stats->max = (int16_t)temperature;
+    }
+
+    p_stats->count++;
+    delta           = temperature - p_stats->mean;
+    p_stats->mean  += delta / p_stats->count;
+    p_stats->m2    += delta * (temperature - p_stats->mean);
+
+    // The factor in single precision for cost: expf() is a software libm routine too, but
+    // its float arithmetic runs on the FPU where exp() would emulate double, and it is good
+    // to a few 1e-5 °C of MKT. The sum stays double, emulated, so that millions of small
+    // terms are not lost against it.
+    p_stats->arrhenius_sum += expf(-(float)STATS_MKT_DH_OVER_R / (temperature * 0.25f + STATS_KELVIN_OFFSET_F));
+}
+
+double stats_mean(stats_t const * p_stats)
+{
+    return p_stats->mean / 4.0;
+}
+
+double stats_stddev(stats_t const * p_stats)
+{
+    if (p_stats->count < 2)
+    {
+        return 0.0;
+    }
+    return sqrt(p_stats->m2 / (p_stats->count - 1)) / 4.0;
+}
+
+double stats_mkt(stats_t const * p_stats)
+{
+    if (p_stats->count == 0)
+    {
+        return 0.0;
+    }
+    return STATS_MKT_DH_OVER_R / -log(p_stats->arrhenius_sum / p_stats->count) - STATS_KELVIN_OFFSET;
+}
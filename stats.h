@@ -0,0 +1,44 @@
+#ifndef STATS_H__
+#define STATS_H__
+
+#include <stdint.h>
+
+/**
+ * @brief Running statistics updated in constant time per sample.
+ *
+ * Mean and variance use Welford's method, so they stay accurate over long trips. The Mean
+ * Kinetic Temperature keeps the sum of the Arrhenius factors exp(-dH / RT) of all samples,
+ * with the activation energy of the USP <1079> definition (dH / R = 10000 K). The factors
+ * are computed in single precision (expf), which is cheaper than double and good to a few
+ * 1e-5 °C of MKT. The Cortex-M4F FPU only does single precision, so the double Welford
+ * updates and the double sum are emulated in software there, once per sample.
+ *
+ * Plain C without hardware dependencies; temperatures are in 0.25 °C units.
+ */
+
+#define STATS_MKT_DH_OVER_R     (10000.0)   /**< Activation energy over the gas constant, in K. */
+
+typedef struct
+{
+    uint32_t count;
+    int16_t  min;
+    int16_t  max;
+    double   mean;              /**< In 0.25 °C units. */
+    double   m2;                /**< Sum of squared differences from the mean. */
+    double   arrhenius_sum;     /**< Sum of exp(-dH / RT) over all samples. */
+} stats_t;
+
+void stats_reset(stats_t * p_stats);
+
+void stats_update(stats_t * p_stats, int32_t temperature);
+
+// Returns the mean in °C.
+double stats_mean(stats_t const * p_stats);
+
+// Returns the sample standard deviation in °C.
+double stats_stddev(stats_t const * p_stats);
+
+// Returns the Mean Kinetic Temperature in °C.
+double stats_mkt(stats_t const * p_stats);
+
+#endif // STATS_H__
@@ -0,0 +1,162 @@
+#include "temp_logger.h"
+#include "nrf.h"
+#include "app_scheduler.h"
+#include "app_error.h"
+#include "nrf_calendar.h"
+#include "temp_sensor.h"
+#include "trip_summary.h"
+#include "calendar_backup.h"
+
+#include "nrf_log.h"
+
+static uint32_t m_interval = 0;
+
+static flash_log_sample_t m_batch[TEMP_LOGGER_MAX_BATCH];
+static uint32_t           m_batch_len  = 0;
+static uint32_t           m_batch_size = TEMP_LOGGER_DEFAULT_BATCH;
+static bool               m_batch_uncertain = false;    /**< Staged samples have uncertain timestamps. */
+static bool               m_low_battery = false;        /**< POFWARN seen since the reset. */
+static uint32_t           m_lost = 0;                   /**< Staged samples dropped by failed commits. */
+
+void temp_logger_init(void)
+{
+    NRF_POWER->EVENTS_POFWARN = 0;
+    NRF_POWER->POFCON = (POWER_POFCON_POF_Enabled << POWER_POFCON_POF_Pos) |
+                        (POWER_POFCON_THRESHOLD_V25 << POWER_POFCON_THRESHOLD_Pos);
+}
+
+flash_log_ret_t temp_logger_flush(void)
+{
+    flash_log_ret_t ret;
+
+    if (m_batch_len == 0)
+    {
+        return FLASH_LOG_SUCCESS;
+    }
+
+    flash_log_time_uncertain_set(m_batch_uncertain);
+    ret = flash_log_append_batch(m_batch, m_batch_len);
+    if (ret != FLASH_LOG_SUCCESS)
+    {
+        // The head of the log is not erased, so a retry would fail the same way. Drop the
+        // staged samples to keep room for new ones, and count them. A batch fails before
+        // its first block is written, as a page is always erased when it is started.
+        m_lost     += m_batch_len;
+        m_batch_len = 0;
+        return ret;
+    }
+
+    m_batch_len = 0;
+    trip_summary_checkpoint();
+    calendar_backup_update();
+    return FLASH_LOG_SUCCESS;
+}
+
+void temp_logger_discard(void)
+{
+    m_batch_len = 0;
+}
+
+flash_log_ret_t temp_logger_batch_set(uint32_t batch)
+{
+    if ((batch == 0) || (batch > TEMP_LOGGER_MAX_BATCH))
+    {
+        return FLASH_LOG_ERROR_INVALID_PARAM;
+    }
+
+    m_batch_size = batch;
+    return temp_logger_flush();
+}
+
+uint32_t temp_logger_batch_get(void)
+{
+    return m_batch_size;
+}
+
+bool temp_logger_low_battery(void)
+{
+    return m_low_battery;
+}
+
+uint32_t temp_logger_lost_get(void)
+{
+    return m_lost;
+}
+
+flash_log_ret_t temp_logger_store(int32_t temperature)
+{
+    flash_log_sample_t * p_sample;
+    bool                 uncertain = nrf_cal_time_uncertain();
+    flash_log_ret_t      ret       = FLASH_LOG_SUCCESS;
+
+    // A block is either trusted or not, so the time being set starts a new one.
+    if (uncertain != m_batch_uncertain)
+    {
+        ret = temp_logger_flush();
+        m_batch_uncertain = uncertain;
+    }
+
+    p_sample = &m_batch[m_batch_len++];
+    p_sample->timestamp   = nrf_cal_get_epoch(true);
+    p_sample->temperature = temperature;
+    trip_summary_update(p_sample);
+
+    // POFWARN only fires as the supply falls through the threshold, so it is latched: from
+    // then on every sample is committed at once rather than lost when the battery gives out.
+    if (NRF_POWER->EVENTS_POFWARN)
+    {
+        NRF_POWER->EVENTS_POFWARN = 0;
+        m_low_battery = true;
+    }
+
+    if (m_low_battery || (m_batch_len >= m_batch_size))
+    {
+        return temp_logger_flush();
+    }
+    return ret;
+}
+
+static void sample_store_evt(void * p_event_data, uint16_t event_size)
+{
+    int32_t temperature = *(int32_t *)p_event_data;
+
+    if (temp_logger_store(temperature) != FLASH_LOG_SUCCESS)
+    {
+        NRF_LOG_WARNING("Periodic samples not stored - flash corrupted, %u lost so far.", m_lost);
+    }
+}
+
+static void sample_ready_handler(int32_t temperature, void * p_context)
+{
+    APP_ERROR_CHECK(app_sched_event_put(&temperature, sizeof(temperature), sample_store_evt));
+}
+
+static void sample_start_evt(void * p_event_data, uint16_t event_size)
+{
+    if (!temp_sensor_sample_request(sample_ready_handler, NULL))
+    {
+        NRF_LOG_WARNING("Periodic sample skipped - sensor busy.");
+    }
+}
+
+static void calendar_handler(void)
+{
+    APP_ERROR_CHECK(app_sched_event_put(NULL, 0, sample_start_evt));
+}
+
+void temp_logger_start(uint32_t interval)
+{
+    m_interval = interval;
+    nrf_cal_set_callback(calendar_handler, interval);
+}
+
+void temp_logger_stop(void)
+{
+    m_interval = 0;
+    nrf_cal_set_callback(NULL, TEMP_LOGGER_DEFAULT_INTERVAL);
+}
+
+uint32_t temp_logger_interval_get(void)
+{
+    return m_interval;
+}
@@ -0,0 +1,64 @@
+#ifndef TEMP_LOGGER_H__
+#define TEMP_LOGGER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_log.h"
+
+/**
+ * @brief Autonomous periodic temperature logging.
+ *
+ * The calendar RTC interrupt only queues a scheduler event. Starting the conversion,
+ * timestamping and appending the sample to the flash log all run from app_sched_execute()
+ * in the main loop, so the interrupt handlers stay short.
+ *
+ * Samples are staged in RAM and committed to flash in one burst once the batch is full,
+ * or on temp_logger_flush(). Once the supply voltage has dropped below the power-fail
+ * threshold, every sample is committed at once until the next reset. Samples taken while
+ * the calendar time is uncertain go to blocks of their own, marked as such in the log.
+ *
+ * If a commit fails, the staged samples are dropped and counted, see temp_logger_lost_get().
+ */
+
+#define TEMP_LOGGER_DEFAULT_INTERVAL    60      /**< Default sampling interval in seconds. */
+#define TEMP_LOGGER_DEFAULT_BATCH       16      /**< Default number of samples staged in RAM. */
+#define TEMP_LOGGER_MAX_BATCH           64
+
+// Configures the power-fail comparator used to flush staged samples on low battery.
+void temp_logger_init(void);
+
+// Starts periodic logging with the given interval in seconds.
+void temp_logger_start(uint32_t interval);
+
+// Stops periodic logging. The calendar keeps running.
+void temp_logger_stop(void);
+
+// Returns the sampling interval in seconds, or 0 if logging is stopped.
+uint32_t temp_logger_interval_get(void);
+
+// Sets how many samples are staged in RAM before they are committed to flash
+// (1 to TEMP_LOGGER_MAX_BATCH). Samples already staged are committed first. Returns
+// FLASH_LOG_ERROR_INVALID_PARAM if the batch is out of range.
+flash_log_ret_t temp_logger_batch_set(uint32_t batch);
+
+// Returns the number of samples staged in RAM before a commit.
+uint32_t temp_logger_batch_get(void);
+
+// Returns true once the supply voltage has dropped below the power-fail threshold. Every
+// sample is then committed on its own, whatever the batch size.
+bool temp_logger_low_battery(void);
+
+// Returns the number of staged samples dropped because committing them failed.
+uint32_t temp_logger_lost_get(void);
+
+// Timestamps a temperature in 0.25 °C units and stages it for the flash log.
+flash_log_ret_t temp_logger_store(int32_t temperature);
+
+// Commits all staged samples to the flash log.
+flash_log_ret_t temp_logger_flush(void);
+
+// Drops the staged samples without committing them. Call before the log is erased, so
+// samples of the old trip do not end up in the new one.
+void temp_logger_discard(void);
+
+#endif // TEMP_LOGGER_H__
@@ -0,0 +1,107 @@
+#include "temp_sensor.h"
+#include "nrf.h"
+#include "nrf_temp.h"
+#include "app_util_platform.h"
+
+typedef struct
+{
+    temp_sensor_handler_t handler;
+    void                * p_context;
+} temp_sensor_request_t;
+
+typedef struct
+{
+    volatile bool ready;
+    int32_t       temperature;
+} temp_sensor_wait_t;
+
+static temp_sensor_request_t m_queue[TEMP_SENSOR_QUEUE_SIZE];
+static uint32_t              m_queue_len = 0;
+
+void temp_sensor_init(void)
+{
+    nrf_temp_init();
+
+    NRF_TEMP->EVENTS_DATARDY = 0;
+    NRF_TEMP->INTENSET = TEMP_INTENSET_DATARDY_Msk;
+    NVIC_ClearPendingIRQ(TEMP_IRQn);
+    NVIC_SetPriority(TEMP_IRQn, TEMP_SENSOR_IRQ_PRIORITY);
+    NVIC_EnableIRQ(TEMP_IRQn);
+}
+
+bool temp_sensor_sample_request(temp_sensor_handler_t handler, void * p_context)
+{
+    bool queued = false;
+
+    CRITICAL_REGION_ENTER();
+    if (m_queue_len < TEMP_SENSOR_QUEUE_SIZE)
+    {
+        m_queue[m_queue_len].handler   = handler;
+        m_queue[m_queue_len].p_context = p_context;
+
+        // The first request starts a conversion, later ones share it.
+        if (m_queue_len++ == 0)
+        {
+            NRF_TEMP->TASKS_START = 1;
+        }
+        queued = true;
+    }
+    CRITICAL_REGION_EXIT();
+
+    return queued;
+}
+
+static void sample_wait_handler(int32_t temperature, void * p_context)
+{
+    temp_sensor_wait_t * p_wait = (temp_sensor_wait_t *)p_context;
+
+    p_wait->temperature = temperature;
+    p_wait->ready       = true;
+}
+
+int32_t temp_sensor_sample_wait(void)
+{
+    temp_sensor_wait_t wait = { .ready = false };
+
+    while (!temp_sensor_sample_request(sample_wait_handler, &wait))
+    {
+        __WFE();
+    }
+    while (!wait.ready)
+    {
+        __WFE();
+    }
+    return wait.temperature;
+}
+
+void TEMP_IRQHandler(void)
+{
+    temp_sensor_request_t requests[TEMP_SENSOR_QUEUE_SIZE];
+    uint32_t count;
+    uint32_t i;
+    int32_t temperature;
+
+    if (NRF_TEMP->EVENTS_DATARDY == 0)
+    {
+        return;
+    }
+
+    NRF_TEMP->EVENTS_DATARDY = 0;
+    temperature = nrf_temp_read();
+    NRF_TEMP->TASKS_STOP = 1;
+
+    // Requests made from the handlers below start a new conversion.
+    CRITICAL_REGION_ENTER();
+    count = m_queue_len;
+    for (i = 0; i < count; i++)
+    {
+        requests[i] = m_queue[i];
+    }
+    m_queue_len = 0;
+    CRITICAL_REGION_EXIT();
+
+    for (i = 0; i < count; i++)
+    {
+        requests[i].handler(temperature, requests[i].p_context);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef TEMP_SENSOR_H__
+#define TEMP_SENSOR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Interrupt-driven driver for the on-chip TEMP sensor.
+ *
+ * A conversion is started with TASKS_START and completes in the TEMP interrupt, so the
+ * CPU can sleep for the duration of the conversion. Requests made while a conversion is
+ * running are queued and served by that same conversion.
+ */
+
+#define TEMP_SENSOR_IRQ_PRIORITY    6
+#define TEMP_SENSOR_QUEUE_SIZE      4
+
+// Called from the TEMP interrupt with the measured temperature in 0.25 °C units.
+typedef void (*temp_sensor_handler_t)(int32_t temperature, void * p_context);
+
+// Initializes the sensor and enables its interrupt.
+void temp_sensor_init(void);
+
+// Requests a sample. Returns false if too many requests are already pending.
+bool temp_sensor_sample_request(temp_sensor_handler_t handler, void * p_context);
+
+// Requests a sample and sleeps until it is ready. Must not be called from an interrupt
+// with priority equal to or higher than TEMP_SENSOR_IRQ_PRIORITY.
+int32_t temp_sensor_sample_wait(void);
+
+#endif // TEMP_SENSOR_H__
@@ -0,0 +1,253 @@
+/**
+ * @brief Host tests of the calendar math in nrf_calendar.c.
+ *
+ * Builds the firmware's nrf_calendar.c against the register stand-ins in host/ and plays
+ * the RTC: the 24-bit counter runs from a 32 kHz crystal with a known error, wraps with
+ * an overflow event, and the test calls the interrupt handler as the NVIC would. Checks
+ * - the 64-bit tick extension, also while an overflow is still pending;
+ * - the rate correction found by setting the time a week apart, and the calibrated time
+ *   over the month after it, against the true time, for crystal errors of up to 500 ppm;
+ * - that setting the time by hand, far beyond any crystal error, keeps the correction;
+ * - that a reset that keeps RAM continues from the retained copy, uncertain.
+ * Prints one line per crystal error and exits with a non-zero status if any check fails.
+ *
+ * Build on Linux:
+ *   gcc -O2 -Ihost -I.. -o caltest caltest.c ../nrf_calendar.c ../civil_time.c
+ *
+ * Usage:
+ *   caltest
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nrf.h"
+#include "civil_time.h"
+#include "nrf_calendar.h"
+
+#define TEST_START_TIME     (1600000000u)
+#define TEST_COUNTER_MASK   (0x00FFFFFFu)
+#define TEST_DAY            (86400u)
+#define TEST_STEP           (60u)       /**< Seconds between checks, well within one counter wrap. */
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            m_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+void RTC0_IRQHandler(void);
+
+NRF_RTC_Type   host_rtc0;
+NRF_CLOCK_Type host_clock;
+
+static uint64_t m_ticks;            /**< Ticks the RTC has counted since it started. */
+static uint64_t m_seconds;          /**< True time since the RTC started. */
+static uint64_t m_base_ticks;       /**< Tick at m_base_seconds of true time. */
+static uint64_t m_base_seconds;
+static int32_t  m_ppm;              /**< Crystal error: positive runs fast. */
+static uint32_t m_failures;
+
+// Counts the RTC up to the given tick, raising the overflow event on a wrap, and runs the
+// interrupt handler unless the test holds it back.
+static void rtc_run(uint64_t ticks, bool interrupt)
+{
+    if ((ticks >> 24) != (m_ticks >> 24))
+    {
+        host_rtc0.EVENTS_OVRFLW = 1;
+    }
+    m_ticks           = ticks;
+    host_rtc0.COUNTER = (uint32_t)ticks & TEST_COUNTER_MASK;
+
+    if (interrupt && host_rtc0.EVENTS_OVRFLW)
+    {
+        RTC0_IRQHandler();
+    }
+}
+
+// Returns the tick the crystal has reached at the given true time, in whole seconds.
+static uint64_t crystal_ticks(uint64_t seconds)
+{
+    int64_t elapsed = (int64_t)(seconds - m_base_seconds) * NRF_CAL_TICKS_PER_SECOND;
+
+    return m_base_ticks + (uint64_t)(elapsed + elapsed * m_ppm / 1000000);
+}
+
+// Lets the true time run for the given seconds in steps, each interrupt on time.
+static void time_run(uint64_t seconds)
+{
+    uint64_t end = m_seconds + seconds;
+
+    for (; m_seconds < end; m_seconds += (end - m_seconds < TEST_STEP) ? end - m_seconds : TEST_STEP)
+    {
+        rtc_run(crystal_ticks(m_seconds), true);
+    }
+    rtc_run(crystal_ticks(m_seconds), true);
+}
+
+// Changes the crystal error from now on.
+static void crystal_set(int32_t ppm)
+{
+    m_base_ticks   = m_ticks;
+    m_base_seconds = m_seconds;
+    m_ppm          = ppm;
+}
+
+static void time_set(uint32_t epoch)
+{
+    civil_time_t time;
+
+    civil_time_from_epoch(epoch, &time);
+    nrf_cal_set_time(time.year, time.month, time.day, time.hour, time.minute, time.second);
+}
+
+static int32_t drift_get(void)
+{
+    nrf_cal_state_t state;
+
+    nrf_cal_state_get(&state);
+    return state.drift_q32;
+}
+
+static void test_tick_extension(void)
+{
+    uint32_t i;
+
+    printf("tick extension\n");
+    for (i = 0; i < 2000; i++)
+    {
+        uint64_t target = m_ticks + 1 + (uint64_t)(rand() % (TEST_COUNTER_MASK / 2));
+
+        // Within half a wrap after an overflow its interrupt may not have run yet: the
+        // pending event counts.
+        rtc_run(target, false);
+        CHECK(nrf_cal_get_ticks() == m_ticks);
+        if (host_rtc0.EVENTS_OVRFLW)
+        {
+            RTC0_IRQHandler();
+        }
+        CHECK(host_rtc0.EVENTS_OVRFLW == 0);
+        CHECK(nrf_cal_get_ticks() == m_ticks);
+    }
+    CHECK((m_ticks >> 32) != 0);
+}
+
+// Sets the time a week apart to calibrate against a crystal off by ppm, then runs a
+// month on the correction and compares the calendar with the true time every minute.
+static void test_month(int32_t ppm)
+{
+    uint32_t epoch       = TEST_START_TIME;
+    int64_t  expected    = -((int64_t)ppm << 32) / (1000000 + ppm);
+    int32_t  max_error   = 0;
+    int32_t  max_drift   = 0;
+    uint32_t i;
+
+    crystal_set(ppm);
+    time_set(epoch);
+    time_run(7 * TEST_DAY);
+    time_set(epoch + 7 * TEST_DAY);
+    CHECK(!nrf_cal_time_uncertain());
+
+    // The week is measured to a tick, so the correction is good to about 0.0001 ppm.
+    CHECK(llabs(drift_get() - expected) < 500);
+
+    for (i = 1; i <= 30 * TEST_DAY / TEST_STEP; i++)
+    {
+        uint32_t now = epoch + 7 * TEST_DAY + i * TEST_STEP;
+        int32_t  error;
+        int32_t  drift;
+
+        time_run(TEST_STEP);
+        error = (int32_t)(nrf_cal_get_epoch(true) - now);
+        drift = (int32_t)(nrf_cal_get_epoch(false) - now);
+        max_error = (abs(error) > abs(max_error)) ? error : max_error;
+        max_drift = (abs(drift) > abs(max_drift)) ? drift : max_drift;
+    }
+
+    printf("  crystal %+4d ppm: correction %+11d, error after a month %+d s calibrated, %+d s uncalibrated\n",
+           ppm,
+           drift_get(),
+           max_error,
+           max_drift);
+
+    // Whole seconds are truncated, so the calendar may read a second behind at most.
+    CHECK((max_error >= -1) && (max_error <= 0));
+    CHECK(abs(max_drift) <= abs(ppm) * 30 * (int32_t)TEST_DAY / 1000000 + 1);
+}
+
+// A set that is off by far more than any crystal, e.g. a wrong time corrected by hand,
+// must not be taken for drift.
+static void test_manual_set(void)
+{
+    int32_t before;
+
+    printf("manual set\n");
+    crystal_set(37);
+    time_set(TEST_START_TIME);
+    time_run(TEST_DAY);
+    time_set(TEST_START_TIME + TEST_DAY);
+    before = drift_get();
+    CHECK(before != 0);
+
+    time_run(TEST_DAY);
+    time_set(TEST_START_TIME + 2 * TEST_DAY + 3600);
+    CHECK(drift_get() == before);
+    CHECK(nrf_cal_get_epoch(true) == TEST_START_TIME + 2 * TEST_DAY + 3600);
+}
+
+// A reset that keeps RAM stops and clears the RTC; the calendar continues from the copy
+// made at the last interrupt, at most one counter wrap old.
+static void test_warm_restore(void)
+{
+    uint32_t now = nrf_cal_get_epoch(true) + 1000;
+    uint32_t epoch;
+
+    printf("warm restore\n");
+    CHECK(!nrf_cal_time_uncertain());
+    time_run(1000);
+    CHECK(now - nrf_cal_get_epoch(true) <= 1);
+
+    m_ticks                 = 0;
+    host_rtc0.COUNTER       = 0;
+    host_rtc0.EVENTS_OVRFLW = 0;
+    nrf_cal_init();
+    nrf_cal_restore(NULL, 0);
+    crystal_set(m_ppm);
+
+    epoch = nrf_cal_get_epoch(true);
+    CHECK(nrf_cal_time_uncertain());
+    CHECK((epoch <= now) && (now - epoch <= 512));
+    CHECK(drift_get() != 0);
+
+    time_set(now + 60);
+    CHECK(!nrf_cal_time_uncertain());
+}
+
+int main(void)
+{
+    static int32_t const ppms[] = { 0, 20, -20, 37, -150, 500, -500 };
+    uint32_t i;
+
+    // The crystal runs already, as when app_timer started it.
+    host_clock.LFCLKSTAT = CLOCK_LFCLKSTAT_STATE_Msk;
+    nrf_cal_init();
+    CHECK(host_rtc0.TASKS_START == 1);
+    CHECK(nrf_cal_time_uncertain());
+    srand(1);
+
+    test_tick_extension();
+    printf("a month on the correction\n");
+    for (i = 0; i < sizeof(ppms) / sizeof(ppms[0]); i++)
+    {
+        test_month(ppms[i]);
+    }
+    test_manual_set();
+    test_warm_restore();
+
+    printf("%s: %u failures\n", (m_failures == 0) ? "ok" : "FAILED", m_failures);
+    return (m_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,31 @@
+/**
+ * @brief Flash access for host builds of flash_log.c.
+ *
+ * The log region is a plain memory image on the host, e.g. a buffer or a privately
+ * mapped file, so programming a word only clears bits and an erase fills the page with 1s.
+ * Every access is counted in flash_log_ram_stats.
+ */
+
+#include <string.h>
+#include "flash_log.h"
+#include "flash_log_ram.h"
+
+flash_log_ram_stats_t flash_log_ram_stats;
+
+void flash_log_nvmc_write_words(uint32_t * p_dst, uint32_t const * p_src, size_t num_words)
+{
+    size_t i;
+
+    flash_log_ram_stats.write_calls++;
+    flash_log_ram_stats.words_written += (uint32_t)num_words;
+    for (i = 0; i < num_words; i++)
+    {
+        p_dst[i] &= p_src[i];
+    }
+}
+
+void flash_log_nvmc_page_erase(uint32_t * p_page)
+{
+    flash_log_ram_stats.page_erases++;
+    memset(p_page, 0xFF, FLASH_LOG_PAGE_SIZE);
+}
@@ -0,0 +1,21 @@
+#ifndef FLASH_LOG_RAM_H__
+#define FLASH_LOG_RAM_H__
+
+#include <stdint.h>
+
+/**
+ * @brief Counters kept by the simulated flash in flash_log_ram.c.
+ *
+ * Tests and benchmarks reset them and read them back to see how hard a piece of code
+ * works the NVMC.
+ */
+typedef struct
+{
+    uint32_t write_calls;       /**< Calls to flash_log_nvmc_write_words(). */
+    uint32_t words_written;     /**< Words programmed over all calls. */
+    uint32_t page_erases;       /**< Calls to flash_log_nvmc_page_erase(). */
+} flash_log_ram_stats_t;
+
+extern flash_log_ram_stats_t flash_log_ram_stats;
+
+#endif // FLASH_LOG_RAM_H__
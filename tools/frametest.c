@@ -0,0 +1,204 @@
+/**
+ * @brief Host tests of the radio frame encoding in radio_frame.c.
+ *
+ * Encodes sample traces into frames the way the sender splits the log, decodes them the
+ * way the gateway does, and checks that every sample comes back unchanged, that frames
+ * end where the format requires it, and that malformed frames are refused. Prints one
+ * line per test and exits with a non-zero status if any check fails.
+ *
+ * Build on Linux:
+ *   gcc -O2 -I.. -o frametest frametest.c ../radio_frame.c
+ *
+ * Usage:
+ *   frametest
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "radio_frame.h"
+
+#define TEST_START_TIME     (1600000000u)
+#define TEST_DEVICE_ID      (0x12345678u)
+#define TEST_TRACE_SAMPLES  (10000u)
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            m_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+static flash_log_sample_t m_samples[TEST_TRACE_SAMPLES];
+static uint32_t           m_failures;
+
+// Sends the trace as a series of frames and decodes each, as sender and gateway do.
+// Returns the number of frames.
+static uint32_t frames_round_trip(flash_log_sample_t const * p_samples, uint32_t count)
+{
+    uint32_t sent   = 0;
+    uint32_t frames = 0;
+
+    while (sent < count)
+    {
+        uint8_t              buf[RADIO_FRAME_MAX_SIZE];
+        radio_frame_header_t header = { RADIO_FRAME_TYPE_SAMPLES, 0, 0, TEST_DEVICE_ID, frames, 0 };
+        radio_frame_header_t decoded;
+        uint32_t             size;
+        uint32_t             i;
+
+        size = radio_frame_encode(buf, &header, &p_samples[sent], count - sent);
+        CHECK(size == RADIO_FRAME_HEADER_SIZE + header.count * RADIO_FRAME_SAMPLE_SIZE);
+        CHECK(header.count > 0);
+        CHECK(header.timestamp == p_samples[sent].timestamp);
+        if (header.count == 0)
+        {
+            return frames;
+        }
+
+        CHECK(radio_frame_decode(buf, size, &decoded));
+        CHECK(decoded.type == RADIO_FRAME_TYPE_SAMPLES);
+        CHECK(decoded.count == header.count);
+        CHECK(decoded.device_id == TEST_DEVICE_ID);
+        CHECK(decoded.sequence == frames);
+        CHECK(decoded.timestamp == header.timestamp);
+
+        for (i = 0; i < decoded.count; i++)
+        {
+            flash_log_sample_t sample;
+
+            radio_frame_sample_get(buf, &decoded, i, &sample);
+            if ((sample.timestamp != p_samples[sent + i].timestamp) ||
+                (sample.temperature != p_samples[sent + i].temperature))
+            {
+                printf("  sample %u: read %u %d\n", sent + i, sample.timestamp, sample.temperature);
+                m_failures++;
+                return frames;
+            }
+        }
+        sent += decoded.count;
+        frames++;
+    }
+    return frames;
+}
+
+static void test_round_trip(void)
+{
+    uint32_t timestamp = TEST_START_TIME;
+    uint32_t frames;
+    uint32_t i;
+
+    printf("round trip\n");
+    for (i = 0; i < TEST_TRACE_SAMPLES; i++)
+    {
+        // Mostly a minute apart, now and then a gap, and every temperature the log stores.
+        timestamp += (rand() % 50 == 0) ? (uint32_t)(rand() % 100000) : 60;
+        m_samples[i].timestamp   = timestamp;
+        m_samples[i].temperature = (int32_t)(rand() % 65536) - 32768;
+    }
+    m_samples[0].temperature = -32768;
+    m_samples[1].temperature = 32767;
+
+    frames = frames_round_trip(m_samples, TEST_TRACE_SAMPLES);
+    printf("  %u samples in %u frames\n", TEST_TRACE_SAMPLES, frames);
+    CHECK(frames >= (TEST_TRACE_SAMPLES + RADIO_FRAME_MAX_SAMPLES - 1) / RADIO_FRAME_MAX_SAMPLES);
+}
+
+// A frame holds RADIO_FRAME_MAX_SAMPLES samples within RADIO_FRAME_MAX_SPAN seconds of
+// the first, and stops before a sample older than the first.
+static void test_frame_end(void)
+{
+    radio_frame_header_t header = { RADIO_FRAME_TYPE_SAMPLES, RADIO_FRAME_FLAG_TIME_UNCERTAIN, 0, TEST_DEVICE_ID, 7, 0 };
+    radio_frame_header_t decoded;
+    uint8_t              buf[RADIO_FRAME_MAX_SIZE];
+    uint32_t             size;
+    uint32_t             i;
+
+    printf("frame end\n");
+    for (i = 0; i < 100; i++)
+    {
+        m_samples[i].timestamp   = TEST_START_TIME + i;
+        m_samples[i].temperature = (int32_t)i;
+    }
+    size = radio_frame_encode(buf, &header, m_samples, 100);
+    CHECK(header.count == RADIO_FRAME_MAX_SAMPLES);
+    CHECK(size <= RADIO_FRAME_MAX_SIZE);
+    CHECK(radio_frame_decode(buf, size, &decoded));
+    CHECK(decoded.flags == RADIO_FRAME_FLAG_TIME_UNCERTAIN);
+
+    m_samples[1].timestamp = TEST_START_TIME + RADIO_FRAME_MAX_SPAN;
+    m_samples[2].timestamp = TEST_START_TIME + RADIO_FRAME_MAX_SPAN + 1;
+    CHECK(radio_frame_encode(buf, &header, m_samples, 3) == RADIO_FRAME_HEADER_SIZE + 2 * RADIO_FRAME_SAMPLE_SIZE);
+    CHECK(header.count == 2);
+
+    // The clock was set back between the first and the second sample.
+    m_samples[1].timestamp = TEST_START_TIME - 1;
+    radio_frame_encode(buf, &header, m_samples, 3);
+    CHECK(header.count == 1);
+
+    CHECK(frames_round_trip(m_samples, 3) == 3);
+}
+
+static void test_ack(void)
+{
+    radio_frame_header_t header = { RADIO_FRAME_TYPE_SAMPLES, RADIO_FRAME_FLAG_TIME_UNCERTAIN, 12, TEST_DEVICE_ID, 42, TEST_START_TIME };
+    radio_frame_header_t decoded;
+    uint8_t              buf[RADIO_FRAME_MAX_SIZE];
+
+    printf("ACK\n");
+    CHECK(radio_frame_ack_encode(buf, &header) == RADIO_FRAME_HEADER_SIZE);
+    CHECK(radio_frame_decode(buf, RADIO_FRAME_HEADER_SIZE, &decoded));
+    CHECK(decoded.type == RADIO_FRAME_TYPE_ACK);
+    CHECK(decoded.flags == 0);
+    CHECK(decoded.count == 0);
+    CHECK(decoded.device_id == TEST_DEVICE_ID);
+    CHECK(decoded.sequence == 42);
+    CHECK(decoded.timestamp == TEST_START_TIME);
+}
+
+static void test_malformed(void)
+{
+    radio_frame_header_t header = { RADIO_FRAME_TYPE_SAMPLES, 0, 0, TEST_DEVICE_ID, 1, 0 };
+    radio_frame_header_t decoded;
+    uint8_t              buf[RADIO_FRAME_MAX_SIZE];
+    uint32_t             size;
+    uint32_t             i;
+
+    printf("malformed frames\n");
+    for (i = 0; i < 10; i++)
+    {
+        m_samples[i].timestamp   = TEST_START_TIME + 60 * i;
+        m_samples[i].temperature = 20;
+    }
+    size = radio_frame_encode(buf, &header, m_samples, 10);
+    CHECK(radio_frame_decode(buf, size, &decoded));
+
+    // Truncated, too long, or with a count that does not match the size.
+    CHECK(!radio_frame_decode(buf, RADIO_FRAME_HEADER_SIZE - 1, &decoded));
+    CHECK(!radio_frame_decode(buf, size - 1, &decoded));
+    CHECK(!radio_frame_decode(buf, size + RADIO_FRAME_SAMPLE_SIZE, &decoded));
+    CHECK(!radio_frame_decode(buf, RADIO_FRAME_MAX_SIZE + 1, &decoded));
+
+    // Unknown type, and an ACK carrying samples.
+    buf[0] = 0x7F;
+    CHECK(!radio_frame_decode(buf, size, &decoded));
+    buf[0] = RADIO_FRAME_TYPE_ACK;
+    CHECK(!radio_frame_decode(buf, size, &decoded));
+}
+
+int main(void)
+{
+    srand(1);
+
+    test_round_trip();
+    test_frame_end();
+    test_ack();
+    test_malformed();
+
+    printf("%s: %u failures\n", (m_failures == 0) ? "ok" : "FAILED", m_failures);
+    return (m_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,252 @@
+/**
+ * @brief Host side of a gateway: turns received radio frames into a time series.
+ *
+ * Reads the PACKET frames streamed by a board in `flash gateway on` mode from a serial
+ * port or a capture file (stdin by default), drops duplicates with the firmware's own
+ * gateway.c and writes every sample once, as CSV or as binary records of 12 bytes:
+ *
+ *   device ID (32 bit) | timestamp (32 bit) | temperature (signed 16 bit, 0.25 °C) |
+ *   flags (8 bit, bit 0: time uncertain) | reserved (8 bit)
+ *
+ * all little endian. Statistics and the processing rate go to stderr at the end of the
+ * stream. With -g, a synthetic capture of interleaved loggers with repeated frames is
+ * written instead, for benchmarks.
+ *
+ * Build on Linux:
+ *   gcc -O2 -I.. -o gateway gateway.c ../gateway.c ../radio_frame.c ../log_dump.c
+ *
+ * Usage:
+ *   gateway [-b] [serial port or capture file] > samples.csv
+ *   gateway -g devices frames > capture.bin
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "gateway.h"
+#include "log_dump.h"
+#include "radio_frame.h"
+
+#define SERIAL_BAUDRATE     B115200
+#define RECORD_SIZE         (12u)
+
+static uint8_t   m_rx_buf[64 * LOG_DUMP_FRAME_MAX_SIZE];
+static size_t    m_rx_len = 0;
+static gateway_t m_gateway;
+static bool      m_binary = false;
+
+static int serial_configure(int fd)
+{
+    struct termios tty;
+
+    if (tcgetattr(fd, &tty) != 0)
+    {
+        // Not a terminal: a capture file or a pipe.
+        return 0;
+    }
+
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, SERIAL_BAUDRATE);
+    cfsetospeed(&tty, SERIAL_BAUDRATE);
+    tty.c_cc[VMIN]  = 1;
+    tty.c_cc[VTIME] = 0;
+
+    return tcsetattr(fd, TCSANOW, &tty);
+}
+
+static void word_put(uint8_t * p_data, uint32_t word)
+{
+    p_data[0] = (uint8_t)word;
+    p_data[1] = (uint8_t)(word >> 8);
+    p_data[2] = (uint8_t)(word >> 16);
+    p_data[3] = (uint8_t)(word >> 24);
+}
+
+static void sample_write(uint32_t device_id, flash_log_sample_t const * p_sample, bool uncertain, void * p_context)
+{
+    (void)p_context;
+
+    if (m_binary)
+    {
+        uint8_t record[RECORD_SIZE];
+
+        word_put(&record[0], device_id);
+        word_put(&record[4], p_sample->timestamp);
+        record[8]  = (uint8_t)p_sample->temperature;
+        record[9]  = (uint8_t)((uint16_t)p_sample->temperature >> 8);
+        record[10] = uncertain ? 1 : 0;
+        record[11] = 0;
+        fwrite(record, sizeof(record), 1, stdout);
+    }
+    else
+    {
+        char      time_string[32];
+        time_t    timestamp = (time_t)p_sample->timestamp;
+        struct tm tm;
+
+        gmtime_r(&timestamp, &tm);
+        strftime(time_string, sizeof(time_string), "%Y-%m-%d %H:%M:%S", &tm);
+        printf("%08X,%u,%s,%.2f,%d\n",
+               device_id,
+               p_sample->timestamp,
+               time_string,
+               p_sample->temperature / 4.0,
+               uncertain);
+    }
+}
+
+// Consumes all complete frames in the receive buffer and skips any text around them.
+static void rx_process(void)
+{
+    log_dump_frame_t     frame;
+    radio_frame_header_t header;
+    size_t               pos = 0;
+
+    while (pos < m_rx_len)
+    {
+        bool   more;
+        size_t frame_length = log_dump_frame_parse(&m_rx_buf[pos], m_rx_len - pos, &frame, &more);
+
+        if (frame_length > 0)
+        {
+            if (frame.type == LOG_DUMP_FRAME_PACKET)
+            {
+                (void)gateway_packet_put(&m_gateway, frame.p_payload, frame.length, &header);
+            }
+            pos += frame_length;
+        }
+        else if (more)
+        {
+            break;
+        }
+        else
+        {
+            pos++;
+        }
+    }
+
+    memmove(m_rx_buf, &m_rx_buf[pos], m_rx_len - pos);
+    m_rx_len -= pos;
+}
+
+static void capture_write(uint8_t const * p_data, size_t length, void * p_context)
+{
+    (void)p_context;
+
+    fwrite(p_data, 1, length, stdout);
+}
+
+// Writes frames from the given number of loggers, taking turns, as a gateway would stream
+// them. One frame in eight is repeated, as if its ACK was lost.
+static int capture_generate(uint32_t devices, uint32_t frames)
+{
+    flash_log_sample_t   samples[RADIO_FRAME_MAX_SAMPLES];
+    radio_frame_header_t header;
+    uint8_t              packet[RADIO_FRAME_MAX_SIZE];
+    uint32_t             size;
+    uint32_t             device;
+    uint32_t             frame;
+    uint32_t             i;
+
+    for (frame = 0; frame < frames; frame++)
+    {
+        for (device = 0; device < devices; device++)
+        {
+            for (i = 0; i < RADIO_FRAME_MAX_SAMPLES; i++)
+            {
+                samples[i].timestamp   = 1600000000u + (frame * RADIO_FRAME_MAX_SAMPLES + i) * 60;
+                samples[i].temperature = (int32_t)((device + frame + i) % 64) - 16;
+            }
+            header.type      = RADIO_FRAME_TYPE_SAMPLES;
+            header.flags     = 0;
+            header.device_id = 0x10000000u + device * 7919u;
+            header.sequence  = device * 1000003u + frame;
+            size = radio_frame_encode(packet, &header, samples, RADIO_FRAME_MAX_SAMPLES);
+
+            log_dump_packet(packet, size, capture_write, NULL);
+            if ((frame + device) % 8 == 0)
+            {
+                log_dump_packet(packet, size, capture_write, NULL);
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char ** argv)
+{
+    struct timespec start;
+    struct timespec end;
+    double          seconds;
+    int             fd = STDIN_FILENO;
+    int             arg = 1;
+
+    if ((argc == 4) && (strcmp(argv[1], "-g") == 0))
+    {
+        return capture_generate(strtoul(argv[2], NULL, 10), strtoul(argv[3], NULL, 10));
+    }
+
+    if ((argc > arg) && (strcmp(argv[arg], "-b") == 0))
+    {
+        m_binary = true;
+        arg++;
+    }
+    if (argc > arg + 1)
+    {
+        fprintf(stderr, "usage: %s [-b] [serial port or capture file]\n", argv[0]);
+        fprintf(stderr, "       %s -g devices frames\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (argc == arg + 1)
+    {
+        fd = open(argv[arg], O_RDONLY | O_NOCTTY);
+        if ((fd < 0) || (serial_configure(fd) != 0))
+        {
+            fprintf(stderr, "gateway: %s: %s\n", argv[arg], strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    gateway_init(&m_gateway, sample_write, NULL);
+    if (!m_binary)
+    {
+        printf("device_id,timestamp,time,temperature,time_uncertain\n");
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (;;)
+    {
+        ssize_t n = read(fd, &m_rx_buf[m_rx_len], sizeof(m_rx_buf) - m_rx_len);
+
+        if (n <= 0)
+        {
+            break;
+        }
+        m_rx_len += (size_t)n;
+        rx_process();
+    }
+    fflush(stdout);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    fprintf(stderr,
+            "gateway: %u devices, %u frames, %u duplicates, %u invalid, %u samples, %u repeated, %u evicted\n",
+            m_gateway.device_count,
+            m_gateway.frames,
+            m_gateway.duplicates,
+            m_gateway.invalid,
+            m_gateway.samples,
+            m_gateway.repeated,
+            m_gateway.evictions);
+    fprintf(stderr, "gateway: %.3f s, %.0f packets/s\n", seconds, m_gateway.packets / seconds);
+
+    return EXIT_SUCCESS;
+}
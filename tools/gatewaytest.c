@@ -0,0 +1,242 @@
+/**
+ * @brief Host tests of the duplicate handling in gateway.c.
+ *
+ * Feeds the firmware's gateway.c the frames a logger sends, with the repeats a lossy link
+ * causes, and checks that every sample is delivered exactly once: frames sent again after
+ * a lost ACK, a transfer resumed from the start of its last unacknowledged frame, a clock
+ * set back, a logger restarted with a new sequence number, and loggers taking turns.
+ * Prints one line per test and exits with a non-zero status if any check fails.
+ *
+ * Build on Linux:
+ *   gcc -O2 -I.. -o gatewaytest gatewaytest.c ../gateway.c ../radio_frame.c
+ *
+ * Usage:
+ *   gatewaytest
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gateway.h"
+#include "radio_frame.h"
+
+#define TEST_START_TIME     (1600000000u)
+#define TEST_INTERVAL       (60u)
+#define TEST_DEVICE_A       (0xA0000001u)
+#define TEST_DEVICE_B       (0xB0000002u)
+#define TEST_MAX_SAMPLES    (4096u)
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            m_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+typedef struct
+{
+    uint32_t           device_id;
+    flash_log_sample_t sample;
+} delivered_t;
+
+static gateway_t          m_gateway;
+static flash_log_sample_t m_samples[TEST_MAX_SAMPLES];     /**< What the logger holds. */
+static delivered_t        m_delivered[TEST_MAX_SAMPLES];
+static uint32_t           m_delivered_count;
+static uint32_t           m_failures;
+
+static void sample_handler(uint32_t device_id, flash_log_sample_t const * p_sample, bool uncertain, void * p_context)
+{
+    (void)uncertain;
+    (void)p_context;
+
+    if (m_delivered_count < TEST_MAX_SAMPLES)
+    {
+        m_delivered[m_delivered_count].device_id = device_id;
+        m_delivered[m_delivered_count].sample    = *p_sample;
+    }
+    m_delivered_count++;
+}
+
+// Sends up to count samples from index first as one frame. Returns the samples it took.
+static uint32_t frame_send(uint32_t device_id, uint32_t sequence, uint32_t first, uint32_t count, gateway_frame_t expected)
+{
+    radio_frame_header_t header = { RADIO_FRAME_TYPE_SAMPLES, 0, 0, device_id, sequence, 0 };
+    radio_frame_header_t received;
+    uint8_t              frame[RADIO_FRAME_MAX_SIZE];
+    uint32_t             size;
+
+    size = radio_frame_encode(frame, &header, &m_samples[first], count);
+    CHECK(gateway_packet_put(&m_gateway, frame, size, &received) == expected);
+    CHECK(received.sequence == sequence);
+    return header.count;
+}
+
+// Checks that deliveries from number from on are the samples from index first on, in
+// order, for the given device.
+static void delivered_check(uint32_t from, uint32_t device_id, uint32_t first, uint32_t count)
+{
+    uint32_t i;
+
+    CHECK(m_delivered_count >= from + count);
+    for (i = 0; (i < count) && (from + i < m_delivered_count); i++)
+    {
+        delivered_t const * p_delivered = &m_delivered[from + i];
+
+        if ((p_delivered->device_id != device_id) ||
+            (p_delivered->sample.timestamp != m_samples[first + i].timestamp) ||
+            (p_delivered->sample.temperature != m_samples[first + i].temperature))
+        {
+            printf("  delivery %u: got %08X %u %d\n",
+                   from + i,
+                   p_delivered->device_id,
+                   p_delivered->sample.timestamp,
+                   p_delivered->sample.temperature);
+            m_failures++;
+            return;
+        }
+    }
+}
+
+static void samples_generate(uint32_t first, uint32_t count, uint32_t timestamp)
+{
+    uint32_t i;
+
+    for (i = first; i < first + count; i++)
+    {
+        m_samples[i].timestamp   = timestamp + (i - first) * TEST_INTERVAL;
+        m_samples[i].temperature = (int32_t)(rand() % 200) - 100;
+    }
+}
+
+static void test_retransmit(void)
+{
+    uint32_t sent = 0;
+    uint32_t sequence;
+
+    printf("retransmitted frames\n");
+    gateway_init(&m_gateway, sample_handler, NULL);
+    m_delivered_count = 0;
+    samples_generate(0, 600, TEST_START_TIME);
+
+    // Every frame twice, as if each first ACK was lost, and an old one late.
+    for (sequence = 100; sent < 600; sequence++)
+    {
+        uint32_t count = frame_send(TEST_DEVICE_A, sequence, sent, 600 - sent, GATEWAY_FRAME_NEW);
+
+        (void)frame_send(TEST_DEVICE_A, sequence, sent, 600 - sent, GATEWAY_FRAME_DUPLICATE);
+        sent += count;
+    }
+    (void)frame_send(TEST_DEVICE_A, 101, RADIO_FRAME_MAX_SAMPLES, 600, GATEWAY_FRAME_DUPLICATE);
+
+    CHECK(m_delivered_count == 600);
+    delivered_check(0, TEST_DEVICE_A, 0, 600);
+    CHECK(m_gateway.repeated == 0);
+}
+
+// The last frame of a transfer arrived but none of its ACKs did; the resumed transfer
+// sends its samples again under a new sequence number, followed by samples logged since.
+static void test_resume(void)
+{
+    uint32_t count;
+
+    printf("resumed transfer\n");
+    gateway_init(&m_gateway, sample_handler, NULL);
+    m_delivered_count = 0;
+    samples_generate(0, 200, TEST_START_TIME);
+
+    count = frame_send(TEST_DEVICE_A, 1, 0, 40, GATEWAY_FRAME_NEW);
+    count += frame_send(TEST_DEVICE_A, 2, count, 30, GATEWAY_FRAME_NEW);
+    CHECK(count == 70);
+
+    // Resumed after sample 39: frame 2 again, grown by the samples logged meanwhile.
+    count = 40 + frame_send(TEST_DEVICE_A, 3, 40, 50, GATEWAY_FRAME_NEW);
+    CHECK(m_delivered_count == count);
+    delivered_check(0, TEST_DEVICE_A, 0, count);
+    CHECK(m_gateway.repeated == 30);
+
+    // And once more, this time without anything new.
+    (void)frame_send(TEST_DEVICE_A, 4, 40, 50, GATEWAY_FRAME_NEW);
+    CHECK(m_delivered_count == count);
+    CHECK(m_gateway.repeated == 80);
+}
+
+// Samples logged after the clock was set back an hour are older than those delivered,
+// and must still be delivered.
+static void test_clock_set_back(void)
+{
+    uint32_t count;
+
+    printf("clock set back\n");
+    gateway_init(&m_gateway, sample_handler, NULL);
+    m_delivered_count = 0;
+    samples_generate(0, 100, TEST_START_TIME);
+    samples_generate(100, 100, TEST_START_TIME + 100 * TEST_INTERVAL - 3600);
+
+    count = frame_send(TEST_DEVICE_A, 1, 0, 100, GATEWAY_FRAME_NEW);
+    count += frame_send(TEST_DEVICE_A, 2, count, 100 - count, GATEWAY_FRAME_NEW);
+    CHECK(count == 100);
+
+    // A frame ends at a sample older than its first, so the set-back starts a frame.
+    count += frame_send(TEST_DEVICE_A, 3, 100, 100, GATEWAY_FRAME_NEW);
+    count += frame_send(TEST_DEVICE_A, 4, count, 200 - count, GATEWAY_FRAME_NEW);
+    CHECK(count == 200);
+    CHECK(m_delivered_count == 200);
+    delivered_check(0, TEST_DEVICE_A, 0, 200);
+    CHECK(m_gateway.repeated == 0);
+}
+
+// A logger that restarts picks a new random sequence number; its frames are new even if
+// the number falls just behind the old one.
+static void test_restart(void)
+{
+    printf("logger restart\n");
+    gateway_init(&m_gateway, sample_handler, NULL);
+    m_delivered_count = 0;
+    samples_generate(0, 100, TEST_START_TIME);
+
+    (void)frame_send(TEST_DEVICE_A, 5000, 0, 50, GATEWAY_FRAME_NEW);
+    (void)frame_send(TEST_DEVICE_A, 5000 - 1000, 50, 50, GATEWAY_FRAME_NEW);
+    (void)frame_send(TEST_DEVICE_A, 5000 - 999, 50, 50, GATEWAY_FRAME_NEW);
+    CHECK(m_delivered_count == 100);
+    delivered_check(0, TEST_DEVICE_A, 0, 100);
+}
+
+// Two loggers with the same timestamps take turns; each keeps its own state.
+static void test_interleaved(void)
+{
+    uint32_t i;
+
+    printf("interleaved loggers\n");
+    gateway_init(&m_gateway, sample_handler, NULL);
+    m_delivered_count = 0;
+    samples_generate(0, 50, TEST_START_TIME);
+
+    for (i = 0; i < 2; i++)
+    {
+        (void)frame_send(TEST_DEVICE_A, 10, 0, 50, (i == 0) ? GATEWAY_FRAME_NEW : GATEWAY_FRAME_DUPLICATE);
+        (void)frame_send(TEST_DEVICE_B, 10, 0, 50, (i == 0) ? GATEWAY_FRAME_NEW : GATEWAY_FRAME_DUPLICATE);
+    }
+    CHECK(m_delivered_count == 100);
+    delivered_check(0, TEST_DEVICE_A, 0, 50);
+    delivered_check(50, TEST_DEVICE_B, 0, 50);
+    CHECK(m_gateway.device_count == 2);
+}
+
+int main(void)
+{
+    srand(1);
+
+    test_retransmit();
+    test_resume();
+    test_clock_set_back();
+    test_restart();
+    test_interleaved();
+
+    printf("%s: %u failures\n", (m_failures == 0) ? "ok" : "FAILED", m_failures);
+    return (m_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
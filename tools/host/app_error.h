@@ -0,0 +1,18 @@
+#ifndef APP_ERROR_H__
+#define APP_ERROR_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Stand-in for the SDK error module in host builds: any error ends the test.
+#define APP_ERROR_CHECK(err_code)                                               \
+    do                                                                          \
+    {                                                                           \
+        if ((err_code) != 0)                                                    \
+        {                                                                       \
+            fprintf(stderr, "%s:%d: error %u\n", __FILE__, __LINE__, (unsigned)(err_code)); \
+            exit(EXIT_FAILURE);                                                 \
+        }                                                                       \
+    } while (0)
+
+#endif // APP_ERROR_H__
@@ -0,0 +1,12 @@
+#ifndef APP_SCHEDULER_H__
+#define APP_SCHEDULER_H__
+
+#include <stdint.h>
+
+// Stand-in for the SDK scheduler in host builds. The test implements app_sched_event_put().
+
+typedef void (*app_sched_event_handler_t)(void * p_event_data, uint16_t event_size);
+
+uint32_t app_sched_event_put(void const * p_event_data, uint16_t event_size, app_sched_event_handler_t handler);
+
+#endif // APP_SCHEDULER_H__
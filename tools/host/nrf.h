@@ -0,0 +1,85 @@
+#ifndef NRF_H__
+#define NRF_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Stand-in for the nRF52840 device header in host builds of the firmware modules.
+ *
+ * Only the registers the host tests drive are modelled. Each peripheral is a plain struct
+ * defined by the test, which plays the hardware: it sets events and reads back tasks.
+ */
+
+typedef struct
+{
+    volatile uint32_t EVENTS_POFWARN;
+    volatile uint32_t POFCON;
+} NRF_POWER_Type;
+
+extern NRF_POWER_Type host_power;
+
+#define NRF_POWER                           (&host_power)
+
+#define POWER_POFCON_POF_Pos                (0UL)
+#define POWER_POFCON_POF_Enabled            (1UL)
+#define POWER_POFCON_THRESHOLD_Pos          (1UL)
+#define POWER_POFCON_THRESHOLD_V25          (12UL)
+
+typedef struct
+{
+    volatile uint32_t TASKS_START;
+    volatile uint32_t EVENTS_OVRFLW;
+    volatile uint32_t EVENTS_COMPARE[4];
+    volatile uint32_t INTENSET;
+    volatile uint32_t INTENCLR;
+    volatile uint32_t EVTENSET;
+    volatile uint32_t EVTENCLR;
+    volatile uint32_t COUNTER;
+    volatile uint32_t PRESCALER;
+    volatile uint32_t CC[4];
+} NRF_RTC_Type;
+
+extern NRF_RTC_Type host_rtc0;
+
+#define NRF_RTC0                            (&host_rtc0)
+#define RTC0_IRQn                           (11)
+
+#define RTC_EVTENSET_OVRFLW_Msk             (1UL << 1)
+#define RTC_INTENSET_OVRFLW_Msk             (1UL << 1)
+#define RTC_INTENSET_COMPARE0_Msk           (1UL << 16)
+
+typedef struct
+{
+    volatile uint32_t TASKS_LFCLKSTART;
+    volatile uint32_t EVENTS_LFCLKSTARTED;
+    volatile uint32_t LFCLKSTAT;
+    volatile uint32_t LFCLKSRC;
+} NRF_CLOCK_Type;
+
+extern NRF_CLOCK_Type host_clock;
+
+#define NRF_CLOCK                           (&host_clock)
+
+#define CLOCK_LFCLKSTAT_STATE_Msk           (1UL << 16)
+#define CLOCK_LFCLKSRC_SRC_Pos              (0UL)
+#define CLOCK_LFCLKSRC_SRC_Xtal             (1UL)
+
+// The test calls the interrupt handlers itself, so the NVIC does nothing.
+static inline void NVIC_SetPriority(int irq, uint32_t priority)
+{
+    (void)irq;
+    (void)priority;
+}
+
+static inline void NVIC_EnableIRQ(int irq)
+{
+    (void)irq;
+}
+
+static inline void NVIC_DisableIRQ(int irq)
+{
+    (void)irq;
+}
+
+#endif // NRF_H__
@@ -0,0 +1,12 @@
+#ifndef NRF_LOG_H__
+#define NRF_LOG_H__
+
+#include <stdio.h>
+
+// Stand-in for the SDK logger in host builds: warnings and errors go to stderr.
+#define NRF_LOG_WARNING(...)    do { fprintf(stderr, "<warning> " __VA_ARGS__); fputc('\n', stderr); } while (0)
+#define NRF_LOG_ERROR(...)      do { fprintf(stderr, "<error> " __VA_ARGS__); fputc('\n', stderr); } while (0)
+#define NRF_LOG_INFO(...)       do { } while (0)
+#define NRF_LOG_DEBUG(...)      do { } while (0)
+
+#endif // NRF_LOG_H__
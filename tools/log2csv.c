@@ -0,0 +1,218 @@
+/**
+ * @brief Host decoder for the `flash dump` stream.
+ *
+ * Reads a dump from a serial port or a capture file (stdin by default), rebuilds the log
+ * region in memory and prints every sample as CSV. The log is decoded by the firmware's
+ * own flash_log.c, mounted on the in-memory image.
+ *
+ * Build on Linux:
+ *   gcc -O2 -I.. -o log2csv log2csv.c flash_log_ram.c ../log_dump.c ../flash_log.c
+ *
+ * Usage:
+ *   log2csv /dev/ttyACM0 > trip.csv      (then run `flash dump` in the device CLI)
+ *   log2csv capture.bin > trip.csv
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "flash_log.h"
+#include "log_dump.h"
+
+#define SERIAL_BAUDRATE     B115200
+
+static uint8_t   m_rx_buf[2 * LOG_DUMP_FRAME_MAX_SIZE];
+static size_t    m_rx_len = 0;
+
+static uint8_t * mp_image      = NULL;
+static uint32_t  m_image_size  = 0;
+static uint32_t  m_page_count  = 0;
+static uint32_t  m_data_frames = 0;
+
+static int serial_configure(int fd)
+{
+    struct termios tty;
+
+    if (tcgetattr(fd, &tty) != 0)
+    {
+        // Not a terminal: a capture file or a pipe.
+        return 0;
+    }
+
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, SERIAL_BAUDRATE);
+    cfsetospeed(&tty, SERIAL_BAUDRATE);
+    tty.c_cc[VMIN]  = 1;
+    tty.c_cc[VTIME] = 0;
+
+    return tcsetattr(fd, TCSANOW, &tty);
+}
+
+static void sample_print(flash_log_sample_t const * p_sample, bool uncertain)
+{
+    char      time_string[32];
+    time_t    timestamp = (time_t)p_sample->timestamp;
+    struct tm tm;
+
+    gmtime_r(&timestamp, &tm);
+    strftime(time_string, sizeof(time_string), "%Y-%m-%d %H:%M:%S", &tm);
+    printf("%u,%s,%.2f,%d\n", p_sample->timestamp, time_string, p_sample->temperature / 4.0, uncertain);
+}
+
+// Returns 1 once the END frame has been handled, -1 on a malformed dump.
+static int frame_handle(log_dump_frame_t const * p_frame)
+{
+    uint32_t offset;
+
+    switch (p_frame->type)
+    {
+        case LOG_DUMP_FRAME_START:
+            if ((p_frame->length != 8) || (log_dump_word_get(p_frame->p_payload) != FLASH_LOG_PAGE_SIZE))
+            {
+                fprintf(stderr, "log2csv: unsupported page size\n");
+                return -1;
+            }
+            m_page_count  = log_dump_word_get(p_frame->p_payload + 4);
+            m_image_size  = m_page_count * FLASH_LOG_PAGE_SIZE;
+            m_data_frames = 0;
+            free(mp_image);
+            mp_image = malloc(m_image_size);
+            if (mp_image == NULL)
+            {
+                return -1;
+            }
+            memset(mp_image, 0xFF, m_image_size);
+            return 0;
+
+        case LOG_DUMP_FRAME_DATA:
+            if (mp_image == NULL)
+            {
+                // Joined the stream late; wait for the next dump.
+                return 0;
+            }
+            offset = log_dump_word_get(p_frame->p_payload);
+            if ((p_frame->length != LOG_DUMP_PAYLOAD_MAX_SIZE) ||
+                (offset > m_image_size - LOG_DUMP_CHUNK_SIZE))
+            {
+                fprintf(stderr, "log2csv: bad chunk at offset %u\n", offset);
+                return -1;
+            }
+            memcpy(mp_image + offset, p_frame->p_payload + 4, LOG_DUMP_CHUNK_SIZE);
+            m_data_frames++;
+            return 0;
+
+        case LOG_DUMP_FRAME_END:
+            if (mp_image == NULL)
+            {
+                return 0;
+            }
+            if (log_dump_word_get(p_frame->p_payload) != m_data_frames)
+            {
+                fprintf(stderr,
+                        "log2csv: received %u of %u chunks\n",
+                        m_data_frames,
+                        log_dump_word_get(p_frame->p_payload));
+                return -1;
+            }
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+// Consumes all complete frames in the receive buffer and skips any text around them.
+static int rx_process(void)
+{
+    log_dump_frame_t frame;
+    size_t           pos = 0;
+    int              ret = 0;
+
+    while ((pos < m_rx_len) && (ret == 0))
+    {
+        bool   more;
+        size_t frame_length = log_dump_frame_parse(&m_rx_buf[pos], m_rx_len - pos, &frame, &more);
+
+        if (frame_length > 0)
+        {
+            ret  = frame_handle(&frame);
+            pos += frame_length;
+        }
+        else if (more)
+        {
+            break;
+        }
+        else
+        {
+            pos++;
+        }
+    }
+
+    memmove(m_rx_buf, &m_rx_buf[pos], m_rx_len - pos);
+    m_rx_len -= pos;
+    return ret;
+}
+
+int main(int argc, char ** argv)
+{
+    flash_log_cursor_t         cursor;
+    flash_log_sample_t const * p_sample;
+    int                        fd  = STDIN_FILENO;
+    int                        ret = 0;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [serial port or capture file]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (argc == 2)
+    {
+        fd = open(argv[1], O_RDONLY | O_NOCTTY);
+        if ((fd < 0) || (serial_configure(fd) != 0))
+        {
+            fprintf(stderr, "log2csv: %s: %s\n", argv[1], strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    while (ret == 0)
+    {
+        ssize_t n = read(fd, &m_rx_buf[m_rx_len], sizeof(m_rx_buf) - m_rx_len);
+
+        if (n <= 0)
+        {
+            fprintf(stderr, "log2csv: stream ended before the end of the dump\n");
+            return EXIT_FAILURE;
+        }
+        m_rx_len += (size_t)n;
+        ret = rx_process();
+    }
+
+    if (ret < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (flash_log_init((uint32_t *)mp_image, m_page_count) != FLASH_LOG_SUCCESS)
+    {
+        fprintf(stderr, "log2csv: log region corrupted\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("timestamp,time,temperature,time_uncertain\n");
+    flash_log_cursor_begin(&cursor);
+    while (flash_log_cursor_next(&cursor, &p_sample) == FLASH_LOG_SUCCESS)
+    {
+        sample_print(p_sample, flash_log_cursor_time_uncertain(&cursor));
+    }
+    fprintf(stderr, "log2csv: %u samples\n", flash_log_count());
+
+    return EXIT_SUCCESS;
+}
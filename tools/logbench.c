@@ -0,0 +1,427 @@
+/**
+ * @brief Host benchmarks of the flash log engine over a simulated flash region.
+ *
+ * Runs the firmware's flash_log.c against a RAM image (see flash_log_ram.c) and prints
+ * CSV. Times are host times, so only their ratios carry over to the device.
+ *
+ * - mount: time of flash_log_init() with 1, 16 and 128 filled pages in a 128-page region,
+ *   with the log starting on the first page or ending on the last page of the region.
+ * - size: flash bytes per sample and decoding speed for synthetic three-week traces,
+ *   appended in batches of 1, 16 and 64 samples, against an 8-byte fixed record.
+ * - seek: time to find the first sample of a window with flash_log_cursor_seek() against
+ *   a linear scan from the oldest sample, on a full-size log of FLASH_LOG_PAGE_COUNT pages.
+ *
+ * Build on Linux:
+ *   gcc -O2 -I.. -o logbench logbench.c flash_log_ram.c ../flash_log.c
+ *
+ * Usage:
+ *   logbench [mount | size | seek]     (runs every benchmark if none is given)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "flash_log.h"
+
+#define BENCH_PAGE_COUNT    (128u)
+#define BENCH_START_TIME    (1600000000u)
+#define BENCH_INTERVAL      (60u)
+#define BENCH_BATCH         (16u)
+#define BENCH_TRACE_SAMPLES (30240u)        /**< Three weeks at one sample a minute. */
+#define BENCH_FIXED_RECORD  (8u)            /**< Bytes of a timestamp and value record. */
+
+static uint32_t           m_region[BENCH_PAGE_COUNT * FLASH_LOG_PAGE_SIZE / sizeof(uint32_t)];
+static flash_log_sample_t m_trace[BENCH_TRACE_SAMPLES];
+
+static double seconds_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static uint32_t * page_get(uint32_t page)
+{
+    return &m_region[page * FLASH_LOG_PAGE_SIZE / sizeof(uint32_t)];
+}
+
+// Erases the region, making the given page the least worn one, so an empty log starts there.
+static void region_reset(uint32_t page_count, uint32_t first_page)
+{
+    uint32_t info = FLASH_LOG_PAGE_INFO(1);
+    uint32_t i;
+
+    memset(m_region, 0xFF, page_count * FLASH_LOG_PAGE_SIZE);
+    for (i = 0; i < page_count; i++)
+    {
+        if (i != first_page)
+        {
+            flash_log_nvmc_write_words(&((flash_log_page_header_t *)page_get(i))->info, &info, 1);
+        }
+    }
+    (void)flash_log_init(m_region, page_count);
+}
+
+// Returns the number of pages that have joined the log.
+static uint32_t pages_started(uint32_t page_count)
+{
+    uint32_t count = 0;
+    uint32_t i;
+
+    for (i = 0; i < page_count; i++)
+    {
+        if (((flash_log_page_header_t const *)page_get(i))->sequence != UINT32_MAX)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Appends a jittered 60 s trace in batches until the given number of pages is full: the
+// next page has been started, or the ring has wrapped when every page is to be filled.
+static void log_fill(uint32_t page_count, uint32_t pages)
+{
+    flash_log_sample_t batch[BENCH_BATCH];
+    uint32_t           timestamp   = BENCH_START_TIME;
+    int32_t            temperature = 4 * 4;
+    uint32_t           appended    = 0;
+
+    for (;;)
+    {
+        uint32_t i;
+
+        for (i = 0; i < BENCH_BATCH; i++)
+        {
+            timestamp   += BENCH_INTERVAL - 1 + (uint32_t)(rand() % 3);
+            temperature += (rand() % 3) - 1;
+            batch[i].timestamp   = timestamp;
+            batch[i].temperature = temperature;
+        }
+        (void)flash_log_append_batch(batch, BENCH_BATCH);
+        appended += BENCH_BATCH;
+
+        if ((flash_log_count() < appended) || (pages_started(page_count) > pages))
+        {
+            return;
+        }
+    }
+}
+
+static void bench_mount(void)
+{
+    static uint32_t const filled[] = { 1, 16, 128 };
+    uint32_t f;
+    uint32_t end;
+
+    printf("region_pages,filled_pages,first_page,samples,mount_us\n");
+    for (f = 0; f < sizeof(filled) / sizeof(filled[0]); f++)
+    {
+        // The scan for the first page of the log is longest when the log ends on the
+        // last page of the region.
+        for (end = 0; end < ((filled[f] < BENCH_PAGE_COUNT) ? 2 : 1); end++)
+        {
+            uint32_t first = end ? BENCH_PAGE_COUNT - 1 - filled[f] : 0;
+            uint32_t runs = 2000;
+            uint32_t i;
+            double   start;
+            double   elapsed;
+
+            region_reset(BENCH_PAGE_COUNT, first);
+            log_fill(BENCH_PAGE_COUNT, filled[f]);
+
+            start = seconds_now();
+            for (i = 0; i < runs; i++)
+            {
+                if (flash_log_init(m_region, BENCH_PAGE_COUNT) != FLASH_LOG_SUCCESS)
+                {
+                    printf("mount failed\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            elapsed = seconds_now() - start;
+
+            printf("%u,%u,%u,%u,%.2f\n",
+                   BENCH_PAGE_COUNT,
+                   filled[f],
+                   first,
+                   flash_log_count(),
+                   elapsed / runs * 1e6);
+        }
+    }
+}
+
+// Returns a sample time one minute after the previous one, give or take the second the
+// RTC callback and the conversion add now and then.
+static uint32_t trace_time_next(uint32_t timestamp)
+{
+    return timestamp + BENCH_INTERVAL + (uint32_t)((rand() % 8 == 0) ? (rand() % 3) - 1 : 0);
+}
+
+// Returns a temperature in 0.25 °C units with a step of sensor noise.
+static int32_t trace_quantize(double degrees)
+{
+    return (int32_t)(degrees * 4 + ((rand() % 3) - 1) * 0.5 + 0.5 * ((degrees >= 0) ? 1 : -1));
+}
+
+// Chilled cargo at 3 °C: the compressor cycles the air by about 0.75 °C every 30 minutes,
+// a defrost warms it by 6 °C for 20 minutes every 6 hours, and the door opens once a day
+// or so for a quarter of an hour.
+static void trace_chilled(void)
+{
+    uint32_t timestamp = BENCH_START_TIME;
+    uint32_t door      = 0;
+    uint32_t i;
+
+    for (i = 0; i < BENCH_TRACE_SAMPLES; i++)
+    {
+        uint32_t minute  = i % 360;
+        double   degrees = 3.0 + 0.75 * (((i % 30) < 15) ? (i % 30) / 15.0 : (30 - i % 30) / 15.0) - 0.375;
+
+        if (minute < 20)
+        {
+            degrees += 6.0 * ((minute < 10) ? minute / 10.0 : (20 - minute) / 10.0);
+        }
+        if ((door == 0) && (rand() % 1440 == 0))
+        {
+            door = 15;
+        }
+        if (door > 0)
+        {
+            degrees += 4.0 + (rand() % 8) / 4.0;
+            door--;
+        }
+
+        timestamp = trace_time_next(timestamp);
+        m_trace[i].timestamp   = timestamp;
+        m_trace[i].temperature = trace_quantize(degrees);
+    }
+}
+
+// Frozen cargo held at -18 °C: only the sensor noise moves.
+static void trace_frozen(void)
+{
+    uint32_t timestamp = BENCH_START_TIME;
+    uint32_t i;
+
+    for (i = 0; i < BENCH_TRACE_SAMPLES; i++)
+    {
+        timestamp = trace_time_next(timestamp);
+        m_trace[i].timestamp   = timestamp;
+        m_trace[i].temperature = trace_quantize(-18.0);
+    }
+}
+
+// Unit switched off: the box follows the day outside, from 15 to 30 °C.
+static void trace_ambient(void)
+{
+    uint32_t timestamp = BENCH_START_TIME;
+    uint32_t i;
+
+    for (i = 0; i < BENCH_TRACE_SAMPLES; i++)
+    {
+        double phase = (i % 1440) / 1440.0;
+
+        timestamp = trace_time_next(timestamp);
+        m_trace[i].timestamp   = timestamp;
+        m_trace[i].temperature = trace_quantize(22.5 + 7.5 * ((phase < 0.5) ? 4 * phase - 1 : 3 - 4 * phase));
+    }
+}
+
+// Worst case for the one-byte deltas: irregular sampling, e.g. many `flash temp` readings
+// between periodic samples, and a sensor moved between boxes at random temperatures.
+static void trace_irregular(void)
+{
+    uint32_t timestamp = BENCH_START_TIME;
+    uint32_t i;
+
+    for (i = 0; i < BENCH_TRACE_SAMPLES; i++)
+    {
+        timestamp += 1 + (uint32_t)(rand() % 600);
+        m_trace[i].timestamp   = timestamp;
+        m_trace[i].temperature = trace_quantize(-25.0 + (rand() % 60));
+    }
+}
+
+static void sample_sum(flash_log_sample_t const * p_sample, void * p_context)
+{
+    *(uint64_t *)p_context += p_sample->timestamp + (uint32_t)p_sample->temperature;
+}
+
+static void bench_size(void)
+{
+    static struct
+    {
+        char const * p_name;
+        void      (* generate)(void);
+    } const traces[] =
+    {
+        { "chilled", trace_chilled },
+        { "frozen",  trace_frozen },
+        { "ambient", trace_ambient },
+        { "irregular", trace_irregular },
+    };
+    static uint32_t const batches[] = { 1, 16, 64 };
+    uint32_t t;
+    uint32_t b;
+
+    printf("trace,batch,samples,bytes_per_sample,vs_fixed_record,samples_per_page,decode_ns_per_sample\n");
+    for (t = 0; t < sizeof(traces) / sizeof(traces[0]); t++)
+    {
+        uint64_t expected = 0;
+        uint32_t i;
+
+        traces[t].generate();
+        for (i = 0; i < BENCH_TRACE_SAMPLES; i++)
+        {
+            expected += m_trace[i].timestamp + (uint32_t)m_trace[i].temperature;
+        }
+
+        for (b = 0; b < sizeof(batches) / sizeof(batches[0]); b++)
+        {
+            flash_log_cursor_t        cursor;
+            flash_log_block_t const * p_block;
+            uint64_t                  bytes = 0;
+            uint32_t                  runs  = 20;
+            double                    start;
+            double                    elapsed;
+            double                    per_sample;
+
+            region_reset(BENCH_PAGE_COUNT, 0);
+            for (i = 0; i < BENCH_TRACE_SAMPLES; i += batches[b])
+            {
+                uint32_t n = (BENCH_TRACE_SAMPLES - i < batches[b]) ? BENCH_TRACE_SAMPLES - i : batches[b];
+
+                (void)flash_log_append_batch(&m_trace[i], n);
+            }
+            if (flash_log_count() != BENCH_TRACE_SAMPLES)
+            {
+                printf("log wrapped\n");
+                exit(EXIT_FAILURE);
+            }
+
+            flash_log_cursor_begin(&cursor);
+            while (flash_log_cursor_block_next(&cursor, &p_block) == FLASH_LOG_SUCCESS)
+            {
+                bytes += sizeof(flash_log_block_t) + ((FLASH_LOG_BLOCK_LENGTH(p_block) + 3) & ~3u);
+            }
+
+            start = seconds_now();
+            for (i = 0; i < runs; i++)
+            {
+                uint64_t sum = 0;
+
+                (void)flash_log_foreach(sample_sum, &sum);
+                if (sum != expected)
+                {
+                    printf("decoded samples differ from the trace\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            elapsed = seconds_now() - start;
+
+            per_sample = (double)bytes / BENCH_TRACE_SAMPLES;
+            printf("%s,%u,%u,%.2f,%.1f,%.0f,%.2f\n",
+                   traces[t].p_name,
+                   batches[b],
+                   BENCH_TRACE_SAMPLES,
+                   per_sample,
+                   BENCH_FIXED_RECORD / per_sample,
+                   (double)BENCH_TRACE_SAMPLES / pages_started(BENCH_PAGE_COUNT),
+                   elapsed / runs / BENCH_TRACE_SAMPLES * 1e9);
+        }
+    }
+}
+
+static void bench_seek(void)
+{
+    static uint32_t            found[2000];     /**< Timestamp each seek landed on. */
+    flash_log_cursor_t         cursor;
+    flash_log_sample_t const * p_sample;
+    uint32_t                   queries = sizeof(found) / sizeof(found[0]);
+    uint32_t                   first;
+    uint32_t                   last;
+    uint32_t                   i;
+    double                     start;
+    double                     seek_time;
+    double                     scan_time;
+
+    region_reset(FLASH_LOG_PAGE_COUNT, 0);
+    log_fill(FLASH_LOG_PAGE_COUNT, FLASH_LOG_PAGE_COUNT);
+
+    flash_log_cursor_begin(&cursor);
+    (void)flash_log_cursor_next(&cursor, &p_sample);
+    first = p_sample->timestamp;
+    last  = first;
+    while (flash_log_cursor_next(&cursor, &p_sample) == FLASH_LOG_SUCCESS)
+    {
+        last = p_sample->timestamp;
+    }
+
+    // The same random window starts for both, checked to land on the same sample.
+    srand(2);
+    start = seconds_now();
+    for (i = 0; i < queries; i++)
+    {
+        uint32_t timestamp = first + (uint32_t)(((uint64_t)rand() * (last - first)) / RAND_MAX);
+
+        flash_log_cursor_seek(&cursor, timestamp);
+        if ((flash_log_cursor_next(&cursor, &p_sample) != FLASH_LOG_SUCCESS) || (p_sample->timestamp < timestamp))
+        {
+            printf("seek failed\n");
+            exit(EXIT_FAILURE);
+        }
+        found[i] = p_sample->timestamp;
+    }
+    seek_time = seconds_now() - start;
+
+    srand(2);
+    start = seconds_now();
+    for (i = 0; i < queries; i++)
+    {
+        uint32_t timestamp = first + (uint32_t)(((uint64_t)rand() * (last - first)) / RAND_MAX);
+
+        flash_log_cursor_begin(&cursor);
+        while ((flash_log_cursor_next(&cursor, &p_sample) == FLASH_LOG_SUCCESS) && (p_sample->timestamp < timestamp))
+        {
+        }
+        if (p_sample->timestamp != found[i])
+        {
+            printf("seek and scan disagree\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    scan_time = seconds_now() - start;
+
+    printf("pages,samples,seek_us,scan_us,speedup\n");
+    printf("%u,%u,%.2f,%.1f,%.0f\n",
+           FLASH_LOG_PAGE_COUNT,
+           flash_log_count(),
+           seek_time / queries * 1e6,
+           scan_time / queries * 1e6,
+           scan_time / seek_time);
+}
+
+int main(int argc, char ** argv)
+{
+    bool all = (argc < 2);
+
+    srand(1);
+
+    if (all || (strcmp(argv[1], "mount") == 0))
+    {
+        bench_mount();
+    }
+    if (all || (strcmp(argv[1], "size") == 0))
+    {
+        bench_size();
+    }
+    if (all || (strcmp(argv[1], "seek") == 0))
+    {
+        bench_seek();
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,270 @@
+/**
+ * @brief Host tests of the RAM staging in temp_logger.c.
+ *
+ * Builds the firmware's temp_logger.c with the trip summary, checkpoint store and flash
+ * log it commits to, over a RAM image of the log region and the checkpoint pages (see
+ * flash_log_ram.c). The calendar and the sensor are replaced by the test, and the stubs
+ * in host/ stand in for the SDK. Prints the flash write calls per 1000 samples for a few
+ * batch sizes, checks the low-battery, erase and failed-commit paths, and exits with a
+ * non-zero status if any check fails.
+ *
+ * Build on Linux:
+ *   gcc -O2 -Ihost -I.. -o loggertest loggertest.c flash_log_ram.c ../temp_logger.c
+ *       ../trip_summary.c ../excursion.c ../stats.c ../checkpoint.c ../calendar_backup.c
+ *       ../flash_log.c -lm
+ *
+ * Usage:
+ *   loggertest
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nrf.h"
+#include "app_scheduler.h"
+#include "checkpoint.h"
+#include "flash_log.h"
+#include "flash_log_ram.h"
+#include "nrf_calendar.h"
+#include "temp_logger.h"
+#include "temp_sensor.h"
+#include "trip_summary.h"
+
+#define TEST_START_TIME     (1600000000u)
+#define TEST_INTERVAL       (60u)
+#define TEST_SAMPLES        (1000u)
+#define TEST_REGION_WORDS   ((FLASH_LOG_PAGE_COUNT + CHECKPOINT_PAGE_COUNT) * FLASH_LOG_PAGE_SIZE / sizeof(uint32_t))
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            m_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+NRF_POWER_Type host_power;
+
+static uint32_t m_region[TEST_REGION_WORDS];   /**< Log pages followed by the checkpoint pages. */
+static uint32_t m_now;
+static uint32_t m_failures;
+
+// Calendar and sensor, played by the test.
+
+bool nrf_cal_time_uncertain(void)
+{
+    return false;
+}
+
+uint32_t nrf_cal_get_epoch(bool calibrated)
+{
+    (void)calibrated;
+    return m_now;
+}
+
+void nrf_cal_set_callback(void (*callback)(void), uint32_t interval)
+{
+    (void)callback;
+    (void)interval;
+}
+
+void nrf_cal_state_get(nrf_cal_state_t * p_state)
+{
+    p_state->epoch     = m_now;
+    p_state->drift_q32 = 0;
+    p_state->uncertain = 0;
+}
+
+void nrf_cal_restore(nrf_cal_state_t const * p_state, uint32_t min_epoch)
+{
+    (void)p_state;
+    (void)min_epoch;
+}
+
+bool temp_sensor_sample_request(temp_sensor_handler_t handler, void * p_context)
+{
+    (void)handler;
+    (void)p_context;
+    return false;
+}
+
+uint32_t app_sched_event_put(void const * p_event_data, uint16_t event_size, app_sched_event_handler_t handler)
+{
+    (void)p_event_data;
+    (void)event_size;
+    (void)handler;
+    return 0;
+}
+
+// Mounts an erased device, as at the first boot.
+static void device_reset(uint32_t batch)
+{
+    memset(m_region, 0xFF, sizeof(m_region));
+    memset(&host_power, 0, sizeof(host_power));
+    m_now = TEST_START_TIME;
+
+    CHECK(flash_log_init(m_region, FLASH_LOG_PAGE_COUNT) == FLASH_LOG_SUCCESS);
+    checkpoint_init(&m_region[FLASH_LOG_PAGE_COUNT * FLASH_LOG_PAGE_SIZE / sizeof(uint32_t)]);
+    trip_summary_init();
+    temp_logger_init();
+    CHECK(temp_logger_batch_set(batch) == FLASH_LOG_SUCCESS);
+    memset(&flash_log_ram_stats, 0, sizeof(flash_log_ram_stats));
+}
+
+// Stores the next sample of a steady trace within the default limits.
+static flash_log_ret_t sample_store(void)
+{
+    m_now += TEST_INTERVAL;
+    return temp_logger_store(5 * 4 + (int32_t)(m_now / TEST_INTERVAL % 4));
+}
+
+static void test_write_count(void)
+{
+    static uint32_t const batches[] = { 1, 16, 64 };
+    uint32_t write_calls[sizeof(batches) / sizeof(batches[0])];
+    uint32_t b;
+    uint32_t i;
+
+    printf("flash writes per %u samples\n", TEST_SAMPLES);
+    for (b = 0; b < sizeof(batches) / sizeof(batches[0]); b++)
+    {
+        device_reset(batches[b]);
+        for (i = 0; i < TEST_SAMPLES; i++)
+        {
+            CHECK(sample_store() == FLASH_LOG_SUCCESS);
+        }
+        CHECK(temp_logger_flush() == FLASH_LOG_SUCCESS);
+        CHECK(flash_log_count() == TEST_SAMPLES);
+        CHECK(trip_summary_stats_get()->count == TEST_SAMPLES);
+
+        write_calls[b] = flash_log_ram_stats.write_calls;
+        printf("  batch %2u: %5u write calls, %5u words, %u erases\n",
+               batches[b],
+               flash_log_ram_stats.write_calls,
+               flash_log_ram_stats.words_written,
+               flash_log_ram_stats.page_erases);
+    }
+
+    // Batching must divide the commits, and with them the write calls, about by the batch.
+    CHECK(write_calls[1] * 8 < write_calls[0]);
+    CHECK(write_calls[2] < write_calls[1]);
+}
+
+static void test_low_battery(void)
+{
+    uint32_t i;
+
+    printf("low battery\n");
+    device_reset(16);
+    for (i = 0; i < 5; i++)
+    {
+        CHECK(sample_store() == FLASH_LOG_SUCCESS);
+    }
+    CHECK(flash_log_count() == 0);
+    CHECK(!temp_logger_low_battery());
+
+    // The event fires once; every sample from then on goes straight to flash.
+    host_power.EVENTS_POFWARN = 1;
+    CHECK(sample_store() == FLASH_LOG_SUCCESS);
+    CHECK(flash_log_count() == 6);
+    CHECK(host_power.EVENTS_POFWARN == 0);
+    CHECK(temp_logger_low_battery());
+    for (i = 7; i <= 10; i++)
+    {
+        CHECK(sample_store() == FLASH_LOG_SUCCESS);
+        CHECK(flash_log_count() == i);
+    }
+}
+
+static void test_failed_commit(void)
+{
+    uint32_t i;
+
+    printf("failed commit\n");
+    device_reset(8);
+    for (i = 0; i < 8; i++)
+    {
+        CHECK(sample_store() == FLASH_LOG_SUCCESS);
+    }
+    CHECK(flash_log_count() == 8);
+
+    // Spoil the erased word at the head of the log, where the next block goes.
+    for (i = sizeof(flash_log_page_header_t) / sizeof(uint32_t); m_region[i] != UINT32_MAX; i++)
+    {
+    }
+    m_region[i] = 0;
+
+    for (i = 0; i < 7; i++)
+    {
+        CHECK(sample_store() == FLASH_LOG_SUCCESS);
+    }
+    CHECK(sample_store() == FLASH_LOG_ERROR_CORRUPTED);
+    CHECK(temp_logger_lost_get() == 8);
+    CHECK(flash_log_count() == 8);
+
+    // The dropped batch makes room: samples are staged again, and dropped with the next
+    // failed commit.
+    for (i = 0; i < 7; i++)
+    {
+        CHECK(sample_store() == FLASH_LOG_SUCCESS);
+    }
+    CHECK(temp_logger_flush() == FLASH_LOG_ERROR_CORRUPTED);
+    CHECK(temp_logger_lost_get() == 15);
+}
+
+// Samples staged when the log is erased belong to the old trip: they must reach neither
+// the new log nor the new summary.
+static void test_erase(void)
+{
+    uint32_t i;
+
+    printf("erase\n");
+    device_reset(16);
+    for (i = 0; i < 20; i++)
+    {
+        CHECK(sample_store() == FLASH_LOG_SUCCESS);
+    }
+    CHECK(flash_log_count() == 16);
+
+    temp_logger_discard();
+    flash_log_erase();
+    trip_summary_reset();
+    CHECK(temp_logger_flush() == FLASH_LOG_SUCCESS);
+    CHECK(flash_log_count() == 0);
+
+    for (i = 0; i < 3; i++)
+    {
+        CHECK(sample_store() == FLASH_LOG_SUCCESS);
+    }
+    CHECK(temp_logger_flush() == FLASH_LOG_SUCCESS);
+    CHECK(flash_log_count() == 3);
+    CHECK(trip_summary_stats_get()->count == 3);
+    CHECK(temp_logger_lost_get() == 0);
+}
+
+static void test_batch_set(void)
+{
+    printf("batch size\n");
+    device_reset(16);
+    CHECK(temp_logger_batch_set(0) == FLASH_LOG_ERROR_INVALID_PARAM);
+    CHECK(temp_logger_batch_set(TEMP_LOGGER_MAX_BATCH + 1) == FLASH_LOG_ERROR_INVALID_PARAM);
+    CHECK(temp_logger_batch_get() == 16);
+    CHECK(temp_logger_batch_set(TEMP_LOGGER_MAX_BATCH) == FLASH_LOG_SUCCESS);
+    CHECK(temp_logger_batch_get() == TEMP_LOGGER_MAX_BATCH);
+}
+
+int main(void)
+{
+    // The low-battery state lasts until the next reset of the chip, so it is tested last.
+    test_write_count();
+    test_batch_set();
+    test_erase();
+    test_failed_commit();
+    test_low_battery();
+
+    printf("%s: %u failures\n", (m_failures == 0) ? "ok" : "FAILED", m_failures);
+    return (m_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,103 @@
+/**
+ * @brief Prints a raw log region image as CSV.
+ *
+ * The image (e.g. read back with `nrfjprog --readcode`, starting at FLASH_LOG_START_ADDR)
+ * is memory-mapped and read through the firmware's cursor API, just like the device reads
+ * its own flash. The mapping is private, so repairs made while mounting never reach the file.
+ *
+ * Build on Linux:
+ *   gcc -O2 -I.. -o logread logread.c flash_log_ram.c ../flash_log.c
+ *
+ * Usage:
+ *   logread region.bin [from timestamp [to timestamp]] > trip.csv
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "flash_log.h"
+
+int main(int argc, char ** argv)
+{
+    flash_log_cursor_t         cursor;
+    flash_log_sample_t const * p_sample;
+    flash_log_ret_t            ret;
+    struct stat                st;
+    uint32_t                 * p_region;
+    uint32_t                   count = 0;
+    uint32_t                   to    = UINT32_MAX;
+    int                        fd;
+
+    if ((argc < 2) || (argc > 4))
+    {
+        fprintf(stderr, "usage: %s <region image> [from timestamp [to timestamp]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    fd = open(argv[1], O_RDONLY);
+    if ((fd < 0) || (fstat(fd, &st) != 0))
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    if ((st.st_size < 2 * FLASH_LOG_PAGE_SIZE) || (st.st_size % FLASH_LOG_PAGE_SIZE != 0))
+    {
+        fprintf(stderr, "logread: %s: not a whole number of log pages\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    p_region = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (p_region == MAP_FAILED)
+    {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+
+    if (flash_log_init(p_region, st.st_size / FLASH_LOG_PAGE_SIZE) != FLASH_LOG_SUCCESS)
+    {
+        fprintf(stderr, "logread: log region corrupted\n");
+        return EXIT_FAILURE;
+    }
+
+    if (argc == 4)
+    {
+        to = (uint32_t)strtoul(argv[3], NULL, 0);
+    }
+    if (argc >= 3)
+    {
+        flash_log_cursor_seek(&cursor, (uint32_t)strtoul(argv[2], NULL, 0));
+    }
+    else
+    {
+        flash_log_cursor_begin(&cursor);
+    }
+
+    printf("timestamp,time,temperature,time_uncertain\n");
+    while (((ret = flash_log_cursor_next(&cursor, &p_sample)) == FLASH_LOG_SUCCESS) &&
+           (p_sample->timestamp <= to))
+    {
+        char      time_string[32];
+        time_t    timestamp = (time_t)p_sample->timestamp;
+        struct tm tm;
+
+        gmtime_r(&timestamp, &tm);
+        strftime(time_string, sizeof(time_string), "%Y-%m-%d %H:%M:%S", &tm);
+        printf("%u,%s,%.2f,%d\n",
+               p_sample->timestamp,
+               time_string,
+               p_sample->temperature / 4.0,
+               flash_log_cursor_time_uncertain(&cursor));
+        count++;
+    }
+
+    fprintf(stderr, "logread: %u samples\n", count);
+    munmap(p_region, st.st_size);
+    close(fd);
+
+    return (ret == FLASH_LOG_ERROR_CORRUPTED) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
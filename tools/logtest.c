@@ -0,0 +1,304 @@
+/**
+ * @brief Host tests of the flash log engine over a simulated flash region.
+ *
+ * Runs the firmware's flash_log.c against a RAM image (see flash_log_ram.c) and checks
+ * what comes back through the cursor against the samples that went in, and how the flash
+ * is programmed on the way. Prints one line per test and exits with a non-zero status if
+ * any check fails.
+ *
+ * Build on Linux:
+ *   gcc -O2 -I.. -o logtest logtest.c flash_log_ram.c ../flash_log.c
+ *
+ * Usage:
+ *   logtest
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flash_log.h"
+#include "flash_log_ram.h"
+
+#define TEST_PAGE_COUNT     (8u)
+#define TEST_START_TIME     (1600000000u)
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            m_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+static uint32_t           m_region[TEST_PAGE_COUNT * FLASH_LOG_PAGE_SIZE / sizeof(uint32_t)];
+static flash_log_sample_t m_samples[4096];
+static uint32_t           m_failures;
+
+static void region_reset(void)
+{
+    memset(m_region, 0xFF, sizeof(m_region));
+    if (flash_log_init(m_region, TEST_PAGE_COUNT) != FLASH_LOG_SUCCESS)
+    {
+        printf("  flash_log_init failed on an erased region\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Appends the samples in batches of the given size, as temp_logger does.
+static void samples_append(flash_log_sample_t const * p_samples, uint32_t count, uint32_t batch)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i += batch)
+    {
+        uint32_t n = (count - i < batch) ? count - i : batch;
+
+        CHECK(flash_log_append_batch(&p_samples[i], n) == FLASH_LOG_SUCCESS);
+    }
+}
+
+// Reads the whole log back and compares it with the given samples.
+static void samples_check(flash_log_sample_t const * p_samples, uint32_t count)
+{
+    flash_log_cursor_t         cursor;
+    flash_log_sample_t const * p_sample;
+    uint32_t                   i = 0;
+
+    CHECK(flash_log_count() == count);
+
+    flash_log_cursor_begin(&cursor);
+    while (flash_log_cursor_next(&cursor, &p_sample) == FLASH_LOG_SUCCESS)
+    {
+        if ((i >= count) ||
+            (p_sample->timestamp != p_samples[i].timestamp) ||
+            (p_sample->temperature != p_samples[i].temperature))
+        {
+            printf("  sample %u: read %u %d\n", i, p_sample->timestamp, p_sample->temperature);
+            m_failures++;
+            return;
+        }
+        i++;
+    }
+    CHECK(i == count);
+}
+
+// Samples every 60 s with a little jitter and a slowly wandering temperature: nearly all
+// deltas take the one-byte form.
+static void trace_steady(uint32_t count)
+{
+    uint32_t timestamp   = TEST_START_TIME;
+    int32_t  temperature = 5 * 4;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        timestamp   += 59 + (uint32_t)(rand() % 3);
+        temperature += (rand() % 3) - 1;
+        m_samples[i].timestamp   = timestamp;
+        m_samples[i].temperature = temperature;
+    }
+}
+
+// Gaps, interval changes and temperature jumps of every size, so most deltas need the
+// escape form, and temperatures at both ends of the stored range.
+static void trace_rough(uint32_t count)
+{
+    static int32_t const extremes[] = { -32768, 32767, 0, -1, 1, -16, 15, -17, 16 };
+    uint32_t timestamp = TEST_START_TIME;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        switch (rand() % 4)
+        {
+            case 0:
+                timestamp += 1 + (uint32_t)(rand() % 4);
+                break;
+            case 1:
+                timestamp += 60;
+                break;
+            case 2:
+                timestamp += (uint32_t)(rand() % 100000);
+                break;
+            default:
+                timestamp += FLASH_LOG_BLOCK_MAX_INTERVAL + (uint32_t)(rand() % 10);
+                break;
+        }
+        m_samples[i].timestamp   = timestamp;
+        m_samples[i].temperature = (rand() % 2) ? extremes[rand() % 9]
+                                                : (int32_t)(rand() % 65536) - 32768;
+    }
+}
+
+static void test_round_trip(char const * p_name, void (*trace)(uint32_t), uint32_t count)
+{
+    static uint32_t const batches[] = { 1, 2, 16, 63, 64, 200 };
+    uint32_t i;
+
+    printf("%s\n", p_name);
+    for (i = 0; i < sizeof(batches) / sizeof(batches[0]); i++)
+    {
+        region_reset();
+        trace(count);
+        samples_append(m_samples, count, batches[i]);
+        samples_check(m_samples, count);
+
+        // Mounting again must find the same samples.
+        CHECK(flash_log_init(m_region, TEST_PAGE_COUNT) == FLASH_LOG_SUCCESS);
+        samples_check(m_samples, count);
+    }
+}
+
+static void test_single(void)
+{
+    flash_log_sample_t sample = { TEST_START_TIME, -123 };
+
+    printf("single sample\n");
+    region_reset();
+    samples_check(&sample, 0);
+    CHECK(flash_log_append(&sample) == FLASH_LOG_SUCCESS);
+    samples_check(&sample, 1);
+}
+
+static void test_uncertain(void)
+{
+    flash_log_cursor_t         cursor;
+    flash_log_sample_t const * p_sample;
+    uint32_t                   i = 0;
+
+    printf("uncertain time\n");
+    region_reset();
+    trace_steady(96);
+    samples_append(&m_samples[0], 32, 16);
+    flash_log_time_uncertain_set(true);
+    samples_append(&m_samples[32], 32, 16);
+    flash_log_time_uncertain_set(false);
+    samples_append(&m_samples[64], 32, 16);
+    samples_check(m_samples, 96);
+
+    flash_log_cursor_begin(&cursor);
+    while (flash_log_cursor_next(&cursor, &p_sample) == FLASH_LOG_SUCCESS)
+    {
+        CHECK(flash_log_cursor_time_uncertain(&cursor) == ((i >= 32) && (i < 64)));
+        i++;
+    }
+}
+
+// Takes the position of every sample and resumes from it, on a log whose timestamps run
+// backwards where the clock was set back, then lets the ring reclaim the oldest pages.
+static void test_position(void)
+{
+    static flash_log_position_t positions[4096];
+    flash_log_cursor_t          cursor;
+    flash_log_cursor_t          resumed;
+    flash_log_sample_t const *  p_sample;
+    uint32_t                    count = 3000;
+    uint32_t                    i     = 0;
+
+    printf("log position\n");
+    region_reset();
+    trace_steady(count);
+    for (i = 1000; i < 2000; i++)
+    {
+        m_samples[i].timestamp -= 86400;
+    }
+    samples_append(m_samples, count, 16);
+    samples_check(m_samples, count);
+
+    i = 0;
+    flash_log_cursor_begin(&cursor);
+    while (flash_log_cursor_next(&cursor, &p_sample) == FLASH_LOG_SUCCESS)
+    {
+        flash_log_cursor_position_get(&cursor, &positions[i++]);
+    }
+    CHECK(i == count);
+
+    for (i = 0; i < count; i++)
+    {
+        CHECK(flash_log_cursor_seek_position(&resumed, &positions[i]));
+        if (i + 1 < count)
+        {
+            if ((flash_log_cursor_next(&resumed, &p_sample) != FLASH_LOG_SUCCESS) ||
+                (p_sample->timestamp != m_samples[i + 1].timestamp) ||
+                (p_sample->temperature != m_samples[i + 1].temperature))
+            {
+                printf("  resuming after sample %u failed\n", i);
+                m_failures++;
+                return;
+            }
+        }
+        else
+        {
+            CHECK(flash_log_cursor_next(&resumed, &p_sample) == FLASH_LOG_ERROR_NOT_FOUND);
+        }
+    }
+
+    // Fill the ring until the first page is reclaimed: its positions are gone.
+    for (i = count; flash_log_count() == i; i += count)
+    {
+        samples_append(m_samples, count, 16);
+    }
+    CHECK(!flash_log_cursor_seek_position(&resumed, &positions[0]));
+    flash_log_cursor_begin(&cursor);
+    CHECK(resumed.p_block == cursor.p_block);
+}
+
+// Appends single samples and checks that each append programs only erased words, i.e.
+// never touches an older record, and how many NVMC write calls it takes.
+static void test_write_count(void)
+{
+    static uint32_t before[sizeof(m_region) / sizeof(uint32_t)];
+    uint32_t count = 2000;
+    uint32_t rewrites = 0;
+    uint32_t i;
+    uint32_t w;
+
+    printf("NVMC writes per record\n");
+    region_reset();
+    trace_steady(count);
+    memset(&flash_log_ram_stats, 0, sizeof(flash_log_ram_stats));
+
+    for (i = 0; i < count; i++)
+    {
+        memcpy(before, m_region, sizeof(m_region));
+        CHECK(flash_log_append(&m_samples[i]) == FLASH_LOG_SUCCESS);
+        for (w = 0; w < sizeof(m_region) / sizeof(uint32_t); w++)
+        {
+            if ((m_region[w] != before[w]) && (before[w] != UINT32_MAX))
+            {
+                rewrites++;
+            }
+        }
+    }
+    samples_check(m_samples, count);
+
+    printf("  %u records: %.3f write calls and %.3f words per record, %u erases\n",
+           count,
+           (double)flash_log_ram_stats.write_calls / count,
+           (double)flash_log_ram_stats.words_written / count,
+           flash_log_ram_stats.page_erases);
+
+    // One burst for the block and one for its value word, plus the header words of the
+    // pages started on the way.
+    CHECK(rewrites == 0);
+    CHECK(flash_log_ram_stats.page_erases == 0);
+    CHECK(flash_log_ram_stats.write_calls <= 2 * count + 3 * TEST_PAGE_COUNT);
+}
+
+int main(void)
+{
+    srand(1);
+
+    test_single();
+    test_round_trip("steady trace", trace_steady, 2000);
+    test_round_trip("rough trace", trace_rough, 1000);
+    test_uncertain();
+    test_position();
+    test_write_count();
+
+    printf("%s: %u failures\n", (m_failures == 0) ? "ok" : "FAILED", m_failures);
+    return (m_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
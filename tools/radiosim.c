@@ -0,0 +1,248 @@
+/**
+ * @brief Loopback simulation of the radio log transfer over a lossy channel.
+ *
+ * Fills an in-memory log, then runs the firmware's radio_link.c against a receiver over a
+ * channel that loses frames and ACKs at random. A transfer that gives up is resumed past
+ * the newest acknowledged sample, like `flash send resume`, until the receiver holds the
+ * whole log; the samples received are checked against the log. Time is counted in air
+ * time on the 1 Mbit profile (see `flash phy`), so goodput is an upper bound that ignores
+ * the CPU.
+ *
+ * Build on Linux:
+ *   gcc -O2 -I.. -o radiosim radiosim.c flash_log_ram.c ../flash_log.c ../radio_frame.c ../radio_link.c
+ *
+ * Usage:
+ *   radiosim [loss percent [samples [seed]]]     (sweeps the loss rate if none is given)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flash_log.h"
+#include "radio_frame.h"
+#include "radio_link.h"
+
+#define SIM_PAGE_COUNT      (FLASH_LOG_PAGE_COUNT)
+#define SIM_START_TIME      (1600000000u)
+#define SIM_INTERVAL        (60u)
+
+static uint32_t             m_region[SIM_PAGE_COUNT * FLASH_LOG_PAGE_SIZE / sizeof(uint32_t)];
+static flash_log_sample_t * mp_samples;         /**< What the log holds, oldest first. */
+static uint32_t             m_sample_count;
+
+typedef struct
+{
+    uint32_t loss;                  /**< Chance of losing a frame or an ACK, per 10000. */
+    uint64_t time_us;               /**< Air time spent, reply windows included. */
+    uint32_t frames;
+    uint32_t retransmits;
+    uint32_t resumes;
+    uint32_t duplicates;            /**< Frames the receiver already had. */
+    uint32_t received;              /**< Samples delivered to the receiver. */
+    bool     ok;                    /**< Every sample arrived once, in order. */
+} sim_result_t;
+
+// Air time of a packet on the 1 Mbit profile: ramp-up, preamble, address, length field,
+// payload and CRC.
+static uint32_t air_time(uint32_t size)
+{
+    return 40 + (1 + 4 + 1 + size + 3) * 8;
+}
+
+static bool lost(uint32_t loss)
+{
+    return (uint32_t)(rand() % 10000) < loss;
+}
+
+static void log_fill(uint32_t count)
+{
+    int32_t  temperature = 4 * 4;
+    uint32_t i;
+
+    memset(m_region, 0xFF, sizeof(m_region));
+    if (flash_log_init(m_region, SIM_PAGE_COUNT) != FLASH_LOG_SUCCESS)
+    {
+        exit(1);
+    }
+
+    mp_samples = malloc(count * sizeof(*mp_samples));
+    for (i = 0; i < count; i++)
+    {
+        temperature += (rand() % 3) - 1;
+        mp_samples[i].timestamp   = SIM_START_TIME + i * SIM_INTERVAL;
+        mp_samples[i].temperature = temperature;
+    }
+    for (i = 0; i < count; i += FLASH_LOG_BLOCK_MAX_SAMPLES)
+    {
+        uint32_t n = (count - i < FLASH_LOG_BLOCK_MAX_SAMPLES) ? count - i : FLASH_LOG_BLOCK_MAX_SAMPLES;
+
+        flash_log_append_batch(&mp_samples[i], n);
+    }
+
+    // The log keeps fewer samples than asked for once it wraps.
+    m_sample_count = flash_log_count();
+    mp_samples    += count - m_sample_count;
+}
+
+static void run(uint32_t loss, sim_result_t * p_result)
+{
+    static radio_link_t  link;
+    flash_log_cursor_t   cursor;
+    radio_frame_header_t header;
+    flash_log_sample_t   sample;
+    uint8_t              ack[RADIO_FRAME_HEADER_SIZE];
+    uint8_t const *      p_frame;
+    uint32_t             size;
+    uint32_t             window = RADIO_LINK_TURNAROUND_US + air_time(RADIO_FRAME_HEADER_SIZE);
+    uint32_t             last_sequence = 0;
+    uint32_t             last_timestamp = 0;
+    uint32_t             last_count = 0;
+    bool                 any = false;
+    flash_log_position_t resume;
+    bool                 resume_valid = false;
+    uint32_t             i;
+
+    memset(p_result, 0, sizeof(*p_result));
+    p_result->loss = loss;
+    p_result->ok   = true;
+
+    radio_link_init(&link, 0x1234, (uint32_t)rand());
+    flash_log_cursor_begin(&cursor);
+    radio_link_start(&link, &cursor, m_sample_count);
+
+    for (;;)
+    {
+        size = radio_link_frame_get(&link, &p_frame);
+        if (size == 0)
+        {
+            p_result->frames      += link.frames_sent;
+            p_result->retransmits += link.retransmits;
+            if (link.state == RADIO_LINK_DONE)
+            {
+                break;
+            }
+            // The receiver went quiet: pick up past the newest sample acknowledged so far,
+            // in this or an earlier transfer.
+            p_result->resumes++;
+            if (link.acked)
+            {
+                resume       = link.acked_position;
+                resume_valid = true;
+            }
+            if (!resume_valid || !flash_log_cursor_seek_position(&cursor, &resume))
+            {
+                flash_log_cursor_begin(&cursor);
+            }
+            radio_link_start(&link, &cursor, m_sample_count);
+            continue;
+        }
+
+        // The sender listens for the whole window unless an ACK arrives.
+        p_result->time_us += air_time(size);
+        if (lost(loss))
+        {
+            p_result->time_us += window;
+            continue;
+        }
+
+        if (!radio_frame_decode(p_frame, size, &header))
+        {
+            p_result->ok = false;
+            break;
+        }
+        if (any && (header.sequence == last_sequence))
+        {
+            p_result->duplicates++;
+        }
+        else
+        {
+            // A resumed transfer repeats the samples of a frame whose ACKs were lost.
+            i = 0;
+            if (any && (header.timestamp == last_timestamp))
+            {
+                i = (header.count < last_count) ? header.count : last_count;
+            }
+            for (; i < header.count; i++)
+            {
+                radio_frame_sample_get(p_frame, &header, i, &sample);
+                if ((p_result->received >= m_sample_count) ||
+                    (sample.timestamp != mp_samples[p_result->received].timestamp) ||
+                    (sample.temperature != mp_samples[p_result->received].temperature))
+                {
+                    p_result->ok = false;
+                }
+                p_result->received++;
+            }
+            last_sequence  = header.sequence;
+            last_timestamp = header.timestamp;
+            last_count     = header.count;
+            any            = true;
+        }
+
+        size = radio_frame_ack_encode(ack, &header);
+        if (lost(loss))
+        {
+            p_result->time_us += window;
+            continue;
+        }
+        p_result->time_us += RADIO_LINK_TURNAROUND_US + air_time(size);
+        radio_link_reply_put(&link, ack, size);
+    }
+
+    p_result->ok = p_result->ok && (p_result->received == m_sample_count);
+}
+
+static void result_print(sim_result_t const * p_result)
+{
+    double seconds = p_result->time_us / 1e6;
+
+    printf("%5.1f,%u,%u,%u,%u,%.1f,%.0f,%.1f,%s\n",
+           p_result->loss / 100.0,
+           p_result->frames,
+           p_result->retransmits,
+           p_result->duplicates,
+           p_result->resumes,
+           seconds * 1000,
+           p_result->received / seconds,
+           p_result->received * RADIO_FRAME_SAMPLE_SIZE * 8 / seconds / 1000,
+           p_result->ok ? "ok" : "MISMATCH");
+}
+
+int main(int argc, char ** argv)
+{
+    static uint32_t const sweep[] = { 0, 100, 500, 1000, 2000, 3000, 4000, 5000 };
+    sim_result_t          result;
+    uint32_t              count = 10000;
+    uint32_t              i;
+    bool                  ok    = true;
+
+    if (argc > 4)
+    {
+        fprintf(stderr, "usage: %s [loss percent [samples [seed]]]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2)
+    {
+        count = strtoul(argv[2], NULL, 10);
+    }
+    srand((argc > 3) ? strtoul(argv[3], NULL, 10) : 1);
+
+    log_fill(count);
+    printf("loss_percent,frames,retransmits,duplicates,resumes,time_ms,samples_per_s,goodput_kbps,check\n");
+
+    if (argc > 1)
+    {
+        run((uint32_t)(strtod(argv[1], NULL) * 100), &result);
+        result_print(&result);
+        return result.ok ? 0 : 1;
+    }
+
+    for (i = 0; i < sizeof(sweep) / sizeof(sweep[0]); i++)
+    {
+        run(sweep[i], &result);
+        result_print(&result);
+        ok = ok && result.ok;
+    }
+    return ok ? 0 : 1;
+}
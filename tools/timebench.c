@@ -0,0 +1,195 @@
+/**
+ * @brief Host benchmark of civil_time.c against the C library's time functions.
+ *
+ * Times the firmware's date conversions against what they replace, on the same random
+ * timestamps from 1970 to 2105, and prints CSV:
+ * - civil_time_from_epoch() against gmtime_r() and localtime_r() in UTC;
+ * - civil_time_to_epoch() against mktime() in UTC and timegm();
+ * - civil_time_format() against gmtime_r() followed by strftime().
+ * Every result is checked against the C library first. Times are host times with glibc,
+ * so only their ratios carry over to the device and newlib, whose localtime() and mktime()
+ * also take the time zone lock and read TZ on every call.
+ *
+ * Build on Linux:
+ *   gcc -O2 -I.. -o timebench timebench.c ../civil_time.c
+ *
+ * Usage:
+ *   timebench
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "civil_time.h"
+
+#define BENCH_COUNT         (1000000u)
+
+static uint32_t        m_epochs[BENCH_COUNT];
+static civil_time_t    m_civil[BENCH_COUNT];
+static struct tm       m_tm[BENCH_COUNT];
+static volatile uint32_t m_sink;    /**< Keeps the compiler from dropping the results. */
+
+static double seconds_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void result_print(char const * p_function, double start, double reference)
+{
+    double ns = (seconds_now() - start) * 1e9 / BENCH_COUNT;
+
+    printf("%s,%.1f,%.2f\n", p_function, ns, (reference > 0) ? ns / reference : 1.0);
+}
+
+// Checks every conversion against the C library before timing anything.
+static bool results_check(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        time_t    epoch = (time_t)m_epochs[i];
+        struct tm tm;
+        char      expected[CIVIL_TIME_STRING_SIZE];
+        char      buf[CIVIL_TIME_STRING_SIZE];
+
+        gmtime_r(&epoch, &tm);
+        civil_time_from_epoch(m_epochs[i], &m_civil[i]);
+        if ((m_civil[i].year != tm.tm_year + 1900) || (m_civil[i].month != tm.tm_mon + 1) ||
+            (m_civil[i].day != tm.tm_mday) || (m_civil[i].hour != tm.tm_hour) ||
+            (m_civil[i].minute != tm.tm_min) || (m_civil[i].second != tm.tm_sec) ||
+            !civil_time_valid(&m_civil[i]) ||
+            (civil_time_to_epoch(&m_civil[i]) != m_epochs[i]) ||
+            (timegm(&tm) != epoch))
+        {
+            printf("timebench: %u converts wrongly\n", m_epochs[i]);
+            return false;
+        }
+
+        strftime(expected, sizeof(expected), "%d/%m/%Y - %H:%M:%S", &tm);
+        civil_time_format(m_epochs[i], buf);
+        if (strcmp(buf, expected) != 0)
+        {
+            printf("timebench: %u formats as %s, not %s\n", m_epochs[i], buf, expected);
+            return false;
+        }
+        m_tm[i] = tm;
+    }
+    return true;
+}
+
+int main(void)
+{
+    char     buf[64];
+    uint32_t sum = 0;
+    double   start;
+    double   reference;
+    uint32_t i;
+
+    // The calendar has no time zone; make the C library's local time UTC as well.
+    setenv("TZ", "UTC", 1);
+    tzset();
+    srand(1);
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        // Uniform up to the end of 2105.
+        m_epochs[i] = (uint32_t)(((uint64_t)rand() * RAND_MAX + rand()) % 4291747200u);
+    }
+    if (!results_check())
+    {
+        return EXIT_FAILURE;
+    }
+
+    printf("function,ns_per_call,relative\n");
+
+    start = seconds_now();
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        civil_time_t time;
+
+        civil_time_from_epoch(m_epochs[i], &time);
+        sum += time.day + time.second;
+    }
+    reference = (seconds_now() - start) * 1e9 / BENCH_COUNT;
+    result_print("civil_time_from_epoch", start, reference);
+
+    start = seconds_now();
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        time_t    epoch = (time_t)m_epochs[i];
+        struct tm tm;
+
+        gmtime_r(&epoch, &tm);
+        sum += (uint32_t)(tm.tm_mday + tm.tm_sec);
+    }
+    result_print("gmtime_r", start, reference);
+
+    start = seconds_now();
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        time_t    epoch = (time_t)m_epochs[i];
+        struct tm tm;
+
+        localtime_r(&epoch, &tm);
+        sum += (uint32_t)(tm.tm_mday + tm.tm_sec);
+    }
+    result_print("localtime_r", start, reference);
+
+    start = seconds_now();
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        sum += civil_time_to_epoch(&m_civil[i]);
+    }
+    reference = (seconds_now() - start) * 1e9 / BENCH_COUNT;
+    result_print("civil_time_to_epoch", start, reference);
+
+    start = seconds_now();
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        struct tm tm = m_tm[i];
+
+        tm.tm_isdst = 0;
+        sum += (uint32_t)mktime(&tm);
+    }
+    result_print("mktime", start, reference);
+
+    start = seconds_now();
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        struct tm tm = m_tm[i];
+
+        sum += (uint32_t)timegm(&tm);
+    }
+    result_print("timegm", start, reference);
+
+    start = seconds_now();
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        civil_time_format(m_epochs[i], buf);
+        sum += (uint32_t)buf[1];
+    }
+    reference = (seconds_now() - start) * 1e9 / BENCH_COUNT;
+    result_print("civil_time_format", start, reference);
+
+    start = seconds_now();
+    for (i = 0; i < BENCH_COUNT; i++)
+    {
+        time_t    epoch = (time_t)m_epochs[i];
+        struct tm tm;
+
+        gmtime_r(&epoch, &tm);
+        strftime(buf, sizeof(buf), "%d/%m/%Y - %H:%M:%S", &tm);
+        sum += (uint32_t)buf[1];
+    }
+    result_print("gmtime_r+strftime", start, reference);
+
+    m_sink = sum;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,504 @@
+/**
+ * @brief Host tests of the trip summary: excursion detection and running statistics.
+ *
+ * Replays temperature traces through the firmware's excursion.c and trip_summary.c, with
+ * the flash log and checkpoint store over a RAM image of their pages (see
+ * flash_log_ram.c), and checks the summary:
+ * - a short hand-made trace against values worked out by hand;
+ * - the running statistics over long synthetic traces against a two-pass reference in
+ *   long double;
+ * - a trace logged across a clock set back, restored after reboots;
+ * - a long synthetic trace, or a recorded one, committed in batches like temp_logger does,
+ *   with resets at random points that lose the staged samples. After every reset the
+ *   summary restored from the last checkpoint and the log must match a reference
+ *   computed here from the committed samples alone.
+ *
+ * A recorded trace is CSV as written by logread or log2csv: timestamp in the first
+ * column, temperature in °C in the third, header line optional.
+ *
+ * Build on Linux:
+ *   gcc -O2 -I.. -o triptest triptest.c flash_log_ram.c ../trip_summary.c ../excursion.c
+ *       ../stats.c ../checkpoint.c ../flash_log.c -lm
+ *
+ * Usage:
+ *   triptest [trace.csv]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checkpoint.h"
+#include "excursion.h"
+#include "flash_log.h"
+#include "flash_log_ram.h"
+#include "stats.h"
+#include "trip_summary.h"
+
+#define TEST_START_TIME     (1600000000u)
+#define TEST_INTERVAL       (60u)
+#define TEST_BATCH          (16u)
+#define TEST_TRACE_MAX      (2000000u)
+#define TEST_REGION_WORDS   ((FLASH_LOG_PAGE_COUNT + CHECKPOINT_PAGE_COUNT) * FLASH_LOG_PAGE_SIZE / sizeof(uint32_t))
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            m_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+static uint32_t             m_region[TEST_REGION_WORDS];   /**< Log pages followed by the checkpoint pages. */
+static flash_log_sample_t * mp_trace;
+static uint32_t             m_trace_len;
+static flash_log_sample_t * mp_committed;                   /**< Samples that reached the log. */
+static uint32_t             m_committed_len;
+static uint32_t             m_failures;
+
+// Mounts the log and the checkpoint store and restores the summary, as at boot.
+static void device_boot(void)
+{
+    CHECK(flash_log_init(m_region, FLASH_LOG_PAGE_COUNT) == FLASH_LOG_SUCCESS);
+    checkpoint_init(&m_region[FLASH_LOG_PAGE_COUNT * FLASH_LOG_PAGE_SIZE / sizeof(uint32_t)]);
+    trip_summary_init();
+}
+
+// Reference verdict, worked out in two passes: every sample is classified first, then the
+// intervals and the runs of samples outside the limits are accounted.
+static void reference_excursion(flash_log_sample_t const * p_samples,
+                                uint32_t                   count,
+                                int16_t                    lower,
+                                int16_t                    upper,
+                                excursion_summary_t      * p_summary)
+{
+    static int8_t states[TEST_TRACE_MAX];
+    uint32_t i;
+
+    memset(p_summary, 0, sizeof(*p_summary));
+    p_summary->lower   = lower;
+    p_summary->upper   = upper;
+    p_summary->samples = count;
+    if (count == 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        int32_t temperature = p_samples[i].temperature;
+
+        states[i] = (temperature > upper) ? 1 : ((temperature < lower) ? -1 : 0);
+        if ((states[i] > 0) && (temperature - upper > p_summary->max_above))
+        {
+            p_summary->max_above = temperature - upper;
+        }
+        if ((states[i] < 0) && (lower - temperature > p_summary->max_below))
+        {
+            p_summary->max_below = lower - temperature;
+        }
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        bool starts = (states[i] != 0) && ((i == 0) || (states[i - 1] == 0));
+        bool ends   = (states[i] == 0) && (i > 0) && (states[i - 1] != 0);
+
+        if ((i > 0) && ((int32_t)(p_samples[i].timestamp - p_samples[i - 1].timestamp) > 0))
+        {
+            uint32_t interval = p_samples[i].timestamp - p_samples[i - 1].timestamp;
+
+            p_summary->time_above += (states[i - 1] > 0) ? interval : 0;
+            p_summary->time_below += (states[i - 1] < 0) ? interval : 0;
+        }
+        if (starts)
+        {
+            p_summary->first_start = (p_summary->count == 0) ? p_samples[i].timestamp : p_summary->first_start;
+            p_summary->last_start  = p_samples[i].timestamp;
+            p_summary->last_end    = 0;
+            p_summary->count++;
+        }
+        if (ends)
+        {
+            p_summary->last_end = p_samples[i].timestamp;
+        }
+    }
+
+    p_summary->state          = states[count - 1];
+    p_summary->last_timestamp = p_samples[count - 1].timestamp;
+}
+
+static bool excursion_equal(excursion_summary_t const * p_a, excursion_summary_t const * p_b)
+{
+    return (p_a->lower == p_b->lower) &&
+           (p_a->upper == p_b->upper) &&
+           (p_a->state == p_b->state) &&
+           (p_a->samples == p_b->samples) &&
+           (p_a->last_timestamp == p_b->last_timestamp) &&
+           (p_a->time_above == p_b->time_above) &&
+           (p_a->time_below == p_b->time_below) &&
+           (p_a->max_above == p_b->max_above) &&
+           (p_a->max_below == p_b->max_below) &&
+           (p_a->count == p_b->count) &&
+           (p_a->first_start == p_b->first_start) &&
+           (p_a->last_start == p_b->last_start) &&
+           (p_a->last_end == p_b->last_end);
+}
+
+// Checks the summary held by trip_summary.c against the committed samples.
+static bool summary_check(void)
+{
+    excursion_summary_t const * p_excursion = trip_summary_excursion_get();
+    stats_t const *             p_stats     = trip_summary_stats_get();
+    excursion_summary_t         expected;
+    int16_t                     min = 0;
+    int16_t                     max = 0;
+    uint32_t                    i;
+
+    reference_excursion(mp_committed, m_committed_len, p_excursion->lower, p_excursion->upper, &expected);
+    for (i = 0; i < m_committed_len; i++)
+    {
+        min = ((i == 0) || (mp_committed[i].temperature < min)) ? (int16_t)mp_committed[i].temperature : min;
+        max = ((i == 0) || (mp_committed[i].temperature > max)) ? (int16_t)mp_committed[i].temperature : max;
+    }
+
+    return excursion_equal(p_excursion, &expected) &&
+           (p_stats->count == m_committed_len) &&
+           ((m_committed_len == 0) || ((p_stats->min == min) && (p_stats->max == max)));
+}
+
+static void test_hand_made(void)
+{
+    static struct
+    {
+        uint32_t seconds;
+        int32_t  temperature;
+    } const trace[] =
+    {
+        {   0, 20 },            // 5 °C, within the chilled limits of 2 to 8 °C.
+        {  60, 40 },            // 10 °C: first excursion starts, 2 °C above.
+        { 120, 36 },
+        { 180, 20 },            // Back within: 120 s above.
+        { 240,  4 },            // 1 °C: second excursion starts.
+        { 300,  0 },            // 0 °C, 2 °C below.
+        { 360, 10 },            // Back within: 120 s below.
+        { 420, 33 },            // 8.25 °C: third excursion, still going on.
+    };
+    excursion_summary_t summary;
+    uint32_t            i;
+
+    printf("hand-made trace\n");
+    excursion_reset(&summary, 2 * 4, 8 * 4);
+    CHECK(excursion_passed(&summary));
+    for (i = 0; i < sizeof(trace) / sizeof(trace[0]); i++)
+    {
+        excursion_update(&summary, TEST_START_TIME + trace[i].seconds, trace[i].temperature);
+    }
+
+    CHECK(!excursion_passed(&summary));
+    CHECK(summary.samples == 8);
+    CHECK(summary.count == 3);
+    CHECK(summary.time_above == 120);
+    CHECK(summary.time_below == 120);
+    CHECK(summary.max_above == 8);
+    CHECK(summary.max_below == 8);
+    CHECK(summary.first_start == TEST_START_TIME + 60);
+    CHECK(summary.last_start == TEST_START_TIME + 420);
+    CHECK(summary.last_end == 0);
+    CHECK(summary.state == 1);
+    CHECK(summary.last_timestamp == TEST_START_TIME + 420);
+
+    // A sample with an earlier timestamp, after the clock was set back, charges no time.
+    excursion_update(&summary, TEST_START_TIME + 400, 20);
+    CHECK(summary.time_above == 120);
+    CHECK(summary.last_end == TEST_START_TIME + 400);
+}
+
+// Checks mean, standard deviation and MKT over traces of two million samples around a
+// few set points, against the same figures computed in long double from all samples.
+static void test_stats(void)
+{
+    static struct
+    {
+        char const * p_name;
+        int32_t      set_point;      /**< In 0.25 °C units. */
+        int32_t      spread;
+    } const profiles[] =
+    {
+        { "frozen",   -20 * 4,   8 },
+        { "chilled",    4 * 4,  16 },
+        { "ambient",   22 * 4,  40 },
+        { "desert",    45 * 4, 120 },
+        { "whole range", 0,    340 },
+    };
+    uint32_t p;
+    uint32_t i;
+
+    printf("statistics\n");
+    for (p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++)
+    {
+        stats_t     stats;
+        long double sum       = 0;
+        long double squares   = 0;
+        long double arrhenius = 0;
+        long double mean;
+        long double stddev;
+        long double mkt;
+        double      mean_error;
+        double      stddev_error;
+        double      mkt_error;
+
+        stats_reset(&stats);
+        for (i = 0; i < TEST_TRACE_MAX; i++)
+        {
+            int32_t temperature = profiles[p].set_point + (rand() % (2 * profiles[p].spread + 1)) - profiles[p].spread;
+
+            mp_trace[i].temperature = temperature;
+            stats_update(&stats, temperature);
+            sum       += temperature / 4.0L;
+            arrhenius += expl(-STATS_MKT_DH_OVER_R / (temperature / 4.0L + 273.15L));
+        }
+        mean = sum / TEST_TRACE_MAX;
+        for (i = 0; i < TEST_TRACE_MAX; i++)
+        {
+            squares += (mp_trace[i].temperature / 4.0L - mean) * (mp_trace[i].temperature / 4.0L - mean);
+        }
+        stddev = sqrtl(squares / (TEST_TRACE_MAX - 1));
+        mkt    = STATS_MKT_DH_OVER_R / -logl(arrhenius / TEST_TRACE_MAX) - 273.15L;
+
+        mean_error   = fabs(stats_mean(&stats) - (double)mean);
+        stddev_error = fabs(stats_stddev(&stats) - (double)stddev);
+        mkt_error    = fabs(stats_mkt(&stats) - (double)mkt);
+        printf("  %-11s mean %8.3f, std dev %7.3f, MKT %8.3f °C; errors %.1e, %.1e, %.1e\n",
+               profiles[p].p_name,
+               (double)mean,
+               (double)stddev,
+               (double)mkt,
+               mean_error,
+               stddev_error,
+               mkt_error);
+        CHECK(stats.count == TEST_TRACE_MAX);
+        CHECK(mean_error < 1e-6);
+        CHECK(stddev_error < 1e-6);
+        CHECK(mkt_error < 1e-3);
+    }
+}
+
+// Chilled cargo at 3 °C, one sample a minute, with defrosts every 6 hours that sometimes
+// overshoot the 8 °C limit, door openings, and a compressor failure that lets the box
+// warm up for half a day in the middle of the trip.
+static void trace_generate(uint32_t count)
+{
+    uint32_t timestamp = TEST_START_TIME;
+    uint32_t door      = 0;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        uint32_t minute  = i % 360;
+        int32_t  temperature = 3 * 4 + (rand() % 5) - 2;
+
+        if (minute < 20)
+        {
+            temperature += ((minute < 10) ? minute : 20 - minute) * ((rand() % 4 == 0) ? 3 : 2);
+        }
+        if ((door == 0) && (rand() % 1440 == 0))
+        {
+            door = 10 + (uint32_t)(rand() % 20);
+        }
+        if (door > 0)
+        {
+            temperature += 16 + (rand() % 12);
+            door--;
+        }
+        if ((i > count / 2) && (i < count / 2 + 720))
+        {
+            temperature += (int32_t)(i - count / 2) / 12;
+        }
+        if (rand() % 1000 == 0)
+        {
+            temperature -= 20;      // Cold air from the evaporator hits the sensor.
+        }
+
+        timestamp += TEST_INTERVAL + (uint32_t)((rand() % 8 == 0) ? (rand() % 3) - 1 : 0);
+        mp_trace[i].timestamp   = timestamp;
+        mp_trace[i].temperature = temperature;
+    }
+    m_trace_len = count;
+}
+
+static bool trace_load(char const * p_path)
+{
+    FILE * p_file = fopen(p_path, "r");
+    char   line[256];
+
+    if (p_file == NULL)
+    {
+        perror(p_path);
+        return false;
+    }
+
+    m_trace_len = 0;
+    while ((fgets(line, sizeof(line), p_file) != NULL) && (m_trace_len < TEST_TRACE_MAX))
+    {
+        unsigned long timestamp;
+        double        degrees;
+        char          time_string[64];
+
+        // logread and log2csv write timestamp,time,temperature,...
+        if (sscanf(line, "%lu,%63[^,],%lf", &timestamp, time_string, &degrees) != 3)
+        {
+            continue;
+        }
+        mp_trace[m_trace_len].timestamp   = (uint32_t)timestamp;
+        mp_trace[m_trace_len].temperature = (int32_t)(degrees * 4 + ((degrees < 0) ? -0.5 : 0.5));
+        m_trace_len++;
+    }
+    fclose(p_file);
+    return m_trace_len > 0;
+}
+
+// Feeds the trace like temp_logger: every sample updates the summary at once, samples
+// are committed in batches, and a checkpoint is offered after every commit. Resets at
+// random points drop the staged samples, then the device boots again.
+static void test_replay(char const * p_name)
+{
+    flash_log_sample_t batch[TEST_BATCH];
+    uint32_t           batch_len   = 0;
+    uint32_t           resets      = 0;
+    uint32_t           mismatches  = 0;
+    uint32_t           i;
+
+    printf("%s: %u samples\n", p_name, m_trace_len);
+    memset(m_region, 0xFF, sizeof(m_region));
+    memset(&flash_log_ram_stats, 0, sizeof(flash_log_ram_stats));
+    m_committed_len = 0;
+    device_boot();
+
+    for (i = 0; i < m_trace_len; i++)
+    {
+        trip_summary_update(&mp_trace[i]);
+        batch[batch_len++] = mp_trace[i];
+
+        if (batch_len == TEST_BATCH)
+        {
+            CHECK(flash_log_append_batch(batch, batch_len) == FLASH_LOG_SUCCESS);
+            memcpy(&mp_committed[m_committed_len], batch, batch_len * sizeof(batch[0]));
+            m_committed_len += batch_len;
+            batch_len        = 0;
+            trip_summary_checkpoint();
+        }
+
+        if (rand() % 2000 == 0)
+        {
+            batch_len = 0;
+            device_boot();
+            resets++;
+            if (!summary_check())
+            {
+                mismatches++;
+            }
+        }
+    }
+
+    CHECK(flash_log_append_batch(batch, batch_len) == FLASH_LOG_SUCCESS);
+    memcpy(&mp_committed[m_committed_len], batch, batch_len * sizeof(batch[0]));
+    m_committed_len += batch_len;
+    trip_summary_checkpoint();
+    CHECK(summary_check());
+    device_boot();
+    CHECK(summary_check());
+
+    // Changing the limits re-evaluates the log, which only holds the newest samples.
+    trip_summary_limits_set(0, 10 * 4);
+    CHECK(trip_summary_excursion_get()->samples == flash_log_count());
+
+    printf("  %u resets, %u mismatches, %u excursions, %u flash write calls\n",
+           resets,
+           mismatches,
+           trip_summary_excursion_get()->count,
+           flash_log_ram_stats.write_calls);
+    CHECK(mismatches == 0);
+}
+
+// Logs a trace, sets the clock back an hour and logs on, rebooting after every commit
+// from then on. The samples since the last checkpoint are
+// found by position; a search by timestamp lands in the samples logged before the clock
+// was set back and replays them a second time.
+static void test_clock_set_back(void)
+{
+    uint32_t timestamp = TEST_START_TIME;
+    uint32_t mismatches = 0;
+    uint32_t i;
+
+    printf("clock set back\n");
+    memset(m_region, 0xFF, sizeof(m_region));
+    m_committed_len = 0;
+    device_boot();
+
+    for (i = 0; i < 20100; i++)
+    {
+        timestamp = (i == 20000) ? timestamp - 3600 : timestamp + TEST_INTERVAL;
+        mp_committed[i].timestamp   = timestamp;
+        mp_committed[i].temperature = rand() % 64;
+        trip_summary_update(&mp_committed[i]);
+
+        if ((i + 1) % TEST_BATCH == 0)
+        {
+            CHECK(flash_log_append_batch(&mp_committed[i + 1 - TEST_BATCH], TEST_BATCH) == FLASH_LOG_SUCCESS);
+            m_committed_len = i + 1;
+            trip_summary_checkpoint();
+            if (i >= 20000)
+            {
+                device_boot();
+                mismatches += summary_check() ? 0 : 1;
+            }
+        }
+    }
+    CHECK(flash_log_append_batch(&mp_committed[m_committed_len], i - m_committed_len) == FLASH_LOG_SUCCESS);
+    m_committed_len = i;
+    trip_summary_checkpoint();
+    CHECK(trip_summary_stats_get()->count == 20100);
+
+    device_boot();
+    CHECK(trip_summary_stats_get()->count == 20100);
+    CHECK(summary_check());
+    CHECK(mismatches == 0);
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [trace.csv]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    mp_trace     = malloc(TEST_TRACE_MAX * sizeof(*mp_trace));
+    mp_committed = malloc(TEST_TRACE_MAX * sizeof(*mp_committed));
+    srand(1);
+
+    test_hand_made();
+    test_stats();
+    test_clock_set_back();
+    if (argc == 2)
+    {
+        if (!trace_load(argv[1]))
+        {
+            fprintf(stderr, "triptest: %s: no samples\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+        test_replay(argv[1]);
+    }
+    else
+    {
+        trace_generate(200000);
+        test_replay("synthetic trace");
+    }
+
+    printf("%s: %u failures\n", (m_failures == 0) ? "ok" : "FAILED", m_failures);
+    return (m_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,139 @@
+/**
+ * @brief Endurance simulation of the wear-leveled flash log.
+ *
+ * Runs the firmware's flash_log.c against a RAM image of the full log region (see
+ * flash_log_ram.c) for a long series of trips: each trip appends a random number of
+ * samples, in batches of 16 like temp_logger, and ends with `flash erase`. Short trips
+ * that never wrap the ring are the case wear-leveling has to handle. The erase count of
+ * every page is printed as CSV at the end, followed by a summary on stderr. Exits with a
+ * non-zero status if the counts spread by more than two erases or the log lost samples.
+ *
+ * Build on Linux:
+ *   gcc -O2 -I.. -o wearsim wearsim.c flash_log_ram.c ../flash_log.c -lm
+ *
+ * Usage:
+ *   wearsim [samples [longest trip in samples [seed]]]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flash_log.h"
+#include "flash_log_ram.h"
+
+#define SIM_PAGE_COUNT      (FLASH_LOG_PAGE_COUNT)
+#define SIM_START_TIME      (1600000000u)
+#define SIM_INTERVAL        (60u)
+#define SIM_BATCH           (16u)
+#define SIM_SHORT_TRIP      (1000u)     /**< Samples that surely fit without wrapping the ring. */
+
+static uint32_t m_region[SIM_PAGE_COUNT * FLASH_LOG_PAGE_SIZE / sizeof(uint32_t)];
+
+int main(int argc, char ** argv)
+{
+    flash_log_sample_t batch[SIM_BATCH];
+    uint64_t           samples     = 5000000;
+    uint32_t           longest     = 20000;
+    uint64_t           appended    = 0;
+    uint32_t           trips       = 0;
+    uint32_t           timestamp   = SIM_START_TIME;
+    int32_t            temperature = 4 * 4;
+    uint32_t           min_count   = UINT32_MAX;
+    uint32_t           max_count   = 0;
+    double             sum         = 0;
+    double             sum_squares = 0;
+    double             mean;
+    bool               ok          = true;
+    uint32_t           i;
+
+    if (argc > 4)
+    {
+        fprintf(stderr, "usage: %s [samples [longest trip in samples [seed]]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        samples = strtoull(argv[1], NULL, 10);
+    }
+    if (argc > 2)
+    {
+        longest = strtoul(argv[2], NULL, 10);
+    }
+    srand((argc > 3) ? strtoul(argv[3], NULL, 10) : 1);
+
+    memset(m_region, 0xFF, sizeof(m_region));
+    if (flash_log_init(m_region, SIM_PAGE_COUNT) != FLASH_LOG_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    while (appended < samples)
+    {
+        uint32_t trip  = SIM_BATCH + (uint32_t)(rand() % (longest + 1));
+        uint32_t count;
+        uint32_t before;
+
+        for (count = 0; (count < trip) && (appended < samples); count += SIM_BATCH)
+        {
+            for (i = 0; i < SIM_BATCH; i++)
+            {
+                timestamp   += SIM_INTERVAL - 1 + (uint32_t)(rand() % 3);
+                temperature += (rand() % 3) - 1;
+                batch[i].timestamp   = timestamp;
+                batch[i].temperature = temperature;
+            }
+            if (flash_log_append_batch(batch, SIM_BATCH) != FLASH_LOG_SUCCESS)
+            {
+                fprintf(stderr, "wearsim: append failed after %llu samples\n", (unsigned long long)appended);
+                return EXIT_FAILURE;
+            }
+            appended += SIM_BATCH;
+        }
+
+        // A short trip must still hold every sample, and remounting must find the same log.
+        before = flash_log_count();
+        if ((count <= SIM_SHORT_TRIP) && (before != count))
+        {
+            ok = false;
+        }
+        if ((flash_log_init(m_region, SIM_PAGE_COUNT) != FLASH_LOG_SUCCESS) || (flash_log_count() != before))
+        {
+            ok = false;
+        }
+
+        flash_log_erase();
+        trips++;
+    }
+
+    printf("page,erase_count\n");
+    for (i = 0; i < SIM_PAGE_COUNT; i++)
+    {
+        uint32_t erase_count = flash_log_erase_count_get(i);
+
+        printf("%u,%u\n", i, erase_count);
+        min_count    = (erase_count < min_count) ? erase_count : min_count;
+        max_count    = (erase_count > max_count) ? erase_count : max_count;
+        sum         += erase_count;
+        sum_squares += (double)erase_count * erase_count;
+    }
+    mean = sum / SIM_PAGE_COUNT;
+
+    fprintf(stderr,
+            "wearsim: %llu samples in %u trips, %u pages, %u erases\n",
+            (unsigned long long)appended,
+            trips,
+            SIM_PAGE_COUNT,
+            flash_log_ram_stats.page_erases);
+    fprintf(stderr,
+            "wearsim: erase counts min %u, max %u, mean %.1f, std dev %.2f\n",
+            min_count,
+            max_count,
+            mean,
+            sqrt(sum_squares / SIM_PAGE_COUNT - mean * mean));
+
+    ok = ok && (max_count - min_count <= 2);
+    fprintf(stderr, "wearsim: %s\n", ok ? "ok" : "FAILED");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,128 @@
+#include "trip_summary.h"
+#include "checkpoint.h"
+
+typedef struct
+{
+    excursion_summary_t  excursion;
+    stats_t              stats;
+    flash_log_position_t position;      /**< Newest sample of the log covered, if excursion.samples > 0. */
+} trip_summary_t;
+
+static trip_summary_t m_trip;
+static trip_summary_t m_saved;          /**< Newest checkpoint. */
+static bool           m_saved_valid = false;
+
+// Places the cursor after the newest sample covered by the summary, or before the oldest
+// one if the summary is empty. The log is not ordered by timestamp once the clock has
+// been set back, so the sample is found by its position. Should its page have been
+// reclaimed, every sample left in the log is newer than it.
+static void cursor_resume(flash_log_cursor_t * p_cursor)
+{
+    if (m_trip.excursion.samples == 0)
+    {
+        flash_log_cursor_begin(p_cursor);
+    }
+    else
+    {
+        (void)flash_log_cursor_seek_position(p_cursor, &m_trip.position);
+    }
+}
+
+// Feeds the samples of the log newer than the summary, or all of them if the summary is
+// empty. With with_stats cleared only the excursion summary is updated.
+static void log_replay(bool with_stats)
+{
+    flash_log_cursor_t         cursor;
+    flash_log_sample_t const * p_sample;
+
+    cursor_resume(&cursor);
+    while (flash_log_cursor_next(&cursor, &p_sample) == FLASH_LOG_SUCCESS)
+    {
+        excursion_update(&m_trip.excursion, p_sample->timestamp, p_sample->temperature);
+        if (with_stats)
+        {
+            stats_update(&m_trip.stats, p_sample->temperature);
+        }
+        flash_log_cursor_position_get(&cursor, &m_trip.position);
+    }
+}
+
+// Every sample seen is committed by now, so the newest sample of the log is the newest
+// one covered. It is found from the last position saved, a few hours of samples back.
+static void checkpoint_write(void)
+{
+    flash_log_cursor_t         cursor;
+    flash_log_sample_t const * p_sample;
+
+    cursor_resume(&cursor);
+    while (flash_log_cursor_next(&cursor, &p_sample) == FLASH_LOG_SUCCESS)
+    {
+        flash_log_cursor_position_get(&cursor, &m_trip.position);
+    }
+
+    checkpoint_save(CHECKPOINT_KEY_TRIP, &m_trip, sizeof(m_trip));
+    m_saved       = m_trip;
+    m_saved_valid = true;
+}
+
+void trip_summary_init(void)
+{
+    m_saved_valid = checkpoint_load(CHECKPOINT_KEY_TRIP, &m_trip, sizeof(m_trip));
+    if (m_saved_valid)
+    {
+        m_saved = m_trip;
+    }
+    else
+    {
+        excursion_profile_t const * p_profile = &g_excursion_profiles[EXCURSION_DEFAULT_PROFILE];
+
+        excursion_reset(&m_trip.excursion, p_profile->lower, p_profile->upper);
+        stats_reset(&m_trip.stats);
+    }
+    log_replay(true);
+}
+
+void trip_summary_update(flash_log_sample_t const * p_sample)
+{
+    excursion_update(&m_trip.excursion, p_sample->timestamp, p_sample->temperature);
+    stats_update(&m_trip.stats, p_sample->temperature);
+}
+
+void trip_summary_checkpoint(void)
+{
+    excursion_summary_t const * p_now   = &m_trip.excursion;
+    excursion_summary_t const * p_saved = &m_saved.excursion;
+
+    if (m_saved_valid &&
+        (p_now->count == p_saved->count) &&
+        (p_now->state == p_saved->state) &&
+        (p_now->last_timestamp - p_saved->last_timestamp < TRIP_SUMMARY_CHECKPOINT_INTERVAL))
+    {
+        return;
+    }
+    checkpoint_write();
+}
+
+void trip_summary_reset(void)
+{
+    excursion_reset(&m_trip.excursion, m_trip.excursion.lower, m_trip.excursion.upper);
+    stats_reset(&m_trip.stats);
+    checkpoint_write();
+}
+
+void trip_summary_limits_set(int16_t lower, int16_t upper)
+{
+    excursion_reset(&m_trip.excursion, lower, upper);
+    log_replay(false);
+    checkpoint_write();
+}
+
+excursion_summary_t const * trip_summary_excursion_get(void)
+{
+    return &m_trip.excursion;
+}
+
+stats_t const * trip_summary_stats_get(void)
+{
+    return &m_trip.stats;
+}
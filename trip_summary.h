@@ -0,0 +1,45 @@
+#ifndef TRIP_SUMMARY_H__
+#define TRIP_SUMMARY_H__
+
+#include <stdint.h>
+#include "flash_log.h"
+#include "excursion.h"
+#include "stats.h"
+
+/**
+ * @brief Trip verdict and statistics kept up to date with every logged sample.
+ *
+ * After a reset the last checkpoint is loaded and the samples logged since then are
+ * replayed from the log. They are found by the log position of the newest sample the
+ * checkpoint covers rather than by timestamp, as timestamps go back when the clock is set
+ * back. The summary only needs to be checkpointed now and then: when the verdict changes,
+ * i.e. an excursion starts or ends, and otherwise at most once every
+ * TRIP_SUMMARY_CHECKPOINT_INTERVAL seconds of samples. The interval is far shorter than
+ * the time the log holds, so the samples to replay are always still there, and the
+ * summary keeps covering the whole trip after the oldest log pages have been reclaimed.
+ */
+
+#define TRIP_SUMMARY_CHECKPOINT_INTERVAL    (6 * 3600)  /**< Longest time between two checkpoints, in seconds. */
+
+// Restores the summary. Call after flash_log_init() and checkpoint_init().
+void trip_summary_init(void);
+
+// Accounts for a new sample.
+void trip_summary_update(flash_log_sample_t const * p_sample);
+
+// Saves the summary if the verdict changed or the last checkpoint is old. Call once every
+// sample seen so far is committed to the log.
+void trip_summary_checkpoint(void);
+
+// Starts a new trip with the current limits.
+void trip_summary_reset(void);
+
+// Changes the limits and re-evaluates every sample in the log against them. The statistics
+// are left alone.
+void trip_summary_limits_set(int16_t lower, int16_t upper);
+
+excursion_summary_t const * trip_summary_excursion_get(void);
+
+stats_t const * trip_summary_stats_get(void);
+
+#endif // TRIP_SUMMARY_H__